@@ -115,7 +115,7 @@ PRIVATE REAL
 dem(AMD am) {
   am->lock.curr = 0.999 * am->lock.curr + 0.001 * fabs(am->pll.delay.im);
   am->lock.prev = am->lock.curr;
-  am->dc = 0.9999f * am->dc + 0.0001f * am->pll.delay.re;
+  am->dc = am->dcw.old * am->dc + am->dcw.new * am->pll.delay.re;
   return am->pll.delay.re - am->dc;
 }
 
@@ -144,8 +144,8 @@ AMDemod(AMD am) {
   case AMdet:
     for (i = 0; i < am->size; i++) {
       am->lock.curr = Cmag(CXBdata(am->ibuf, i));
-      am->dc = 0.9999f * am->dc + 0.0001f * am->lock.curr;
-      am->smooth = 0.5f * am->smooth + 0.5f * (am->lock.curr - am->dc);
+      am->dc = am->dcw.old * am->dc + am->dcw.new * am->lock.curr;
+      am->smooth = am->smw.old * am->smooth + am->smw.new * (am->lock.curr - am->dc);
       /* demout = am->smooth; */
       CXBdata(am->obuf, i) = Cmplx(am->smooth, am->smooth);
     }
@@ -190,10 +190,29 @@ newAMD(REAL samprate,
   am->lock.curr = 0.5;
   am->lock.prev = 1.0;
   am->dc = 0.0;
+  am->dcw.old = 0.9999f, am->dcw.new = 0.0001f;
+  am->smw.old = 0.5f, am->smw.new = 0.5f;
 
   return am;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief Run an AM demodulator on every stride-th sample
+*
+* keeps the DC tracker and output smoothing
+* to the same time constants as at the full rate;
+* the pll already goes by the rate it was made with
+*
+* @param am 
+* @param stride 
+*/
+/* ---------------------------------------------------------------------------- */
+void
+strideAMD(AMD am, int stride) {
+  am->dcw.old = (REAL) pow(0.9999, stride), am->dcw.new = 1.0f - am->dcw.old;
+  am->smw.old = (REAL) pow(0.5, stride), am->smw.new = 1.0f - am->smw.old;
+}
+
 void
 /* -------------------------------------------------------------------------- */
 /** @brief delete an AM Demodulation object
@@ -66,6 +66,7 @@ typedef struct _am_demod {
   struct { REAL curr, prev; } lock;
 
   REAL dc, smooth;
+  struct { REAL old, new; } dcw, smw;	// one-pole weights, old + new = 1
   AMMode mode;
 } AMDDesc, *AMD;
 
@@ -77,6 +78,7 @@ extern AMD newAMD(REAL samprate,
 		  REAL f_bandwid,
 		  int size,
 		  COMPLEX * ivec, COMPLEX * ovec, AMMode mode, char *tag);
+extern void strideAMD(AMD am, int stride);
 extern void delAMD(AMD am);
 
 #ifndef TWOPI
@@ -47,6 +47,7 @@ Bridgewater, NJ 08807
 #include <window.h>
 #include <ovsv.h>
 #include <filter.h>
+#include <filtcache.h>
 #include <oscillator.h>
 #include <hilbert.h>
 #include <lmadf.h>
@@ -69,6 +70,7 @@ Bridgewater, NJ 08807
 #include <hilbert.h>
 #include <halfband.h>
 #include <waveshape.h>
+#include <stats.h>
 
 #include <sdrexport.h>
 #include <local.h>
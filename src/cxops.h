@@ -229,6 +229,26 @@ CmulSSE3(COMPLEX *c, COMPLEX *a, COMPLEX *b, int len)
       *cPtr = Cmul(*aPtr,*bPtr);
 }
 
+// c += a * b, for accumulating partitioned convolutions
+
+PRIVATE INLINE
+void
+CmacSSE3(COMPLEX *c, COMPLEX *a, COMPLEX *b, int len)
+{
+  COMPLEX prod[2] __attribute__ ((aligned (16)));
+  int i;
+
+  for(i=0;i<len-1;i+=2) {
+    sse3ComplexMult(prod, a + i, b + i);
+    _mm_store_ps((float *)(c + i),
+		 _mm_add_ps(_mm_load_ps((float *)(c + i)),
+			    _mm_load_ps((float *)prod)));
+  }
+
+  if (len%2) //take care of the odd dangler
+      c[i] = Cadd(c[i], Cmul(a[i],b[i]));
+}
+
 
 
 // The following routines are adapted from code done by  Phil Covington, N8VB
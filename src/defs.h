@@ -44,6 +44,7 @@ Bridgewater, NJ 08807
 #define DEFOFFS (0)
 
 #define MAXRX (4)
+#define MAXSPEC (4)
 
 #ifndef MAXPATHLEN
 #define MAXPATHLEN (2048)
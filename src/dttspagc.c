@@ -231,6 +231,46 @@ DttSPAgc(DTTSPAGC a, int tick) {
   }
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief resizeDttSPAgc 
+* 
+* move a running AGC onto a new buffer size;
+* settings and gain are untouched, the lookahead
+* delay line is copied newest-first into circ,
+* which has to hold 2 * BufSize
+*
+* @param a 
+* @param circ 
+* @param Vec 
+* @param BufSize 
+* @return COMPLEX * the old delay line, for freeing 
+*/
+/* ---------------------------------------------------------------------------- */
+COMPLEX *
+resizeDttSPAgc(DTTSPAGC a, COMPLEX *circ, COMPLEX *Vec, int BufSize) {
+  COMPLEX *old = a->circ;
+  int i,
+      mask = 2 * BufSize - 1,
+      n = min(a->mask, mask) + 1,
+      sndx = (a->sndx - a->indx) & a->mask,
+      fastindx = (a->fastindx - a->indx) & a->mask;
+
+  // indices run downward, so older samples sit above indx
+  for (i = 0; i < n; i++)
+    circ[i] = old[(a->indx + i) & a->mask];
+
+  a->circ = circ;
+  a->mask = mask;
+  a->indx = 0;
+  a->sndx = min(sndx, mask);
+  a->fastindx = min(fastindx, mask);
+
+  CXBbase(a->buff) = Vec;
+  CXBsize(a->buff) = CXBwant(a->buff) = BufSize;
+
+  return old;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief delDttSPAgc 
 * 
@@ -103,5 +103,6 @@ extern DTTSPAGC newDttSPAgc(AGCMODE mode,
 			    REAL Curgain,
 			    char *tag);
 extern void delDttSPAgc(DTTSPAGC a);
+extern COMPLEX *resizeDttSPAgc(DTTSPAGC a, COMPLEX *circ, COMPLEX *Vec, int BufSize);
 
 #endif
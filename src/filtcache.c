@@ -0,0 +1,166 @@
+/** 
+* @file filtcache.c
+* @brief Cache of designed filter responses 
+* @author DttSP contributors
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 by the DttSP contributors
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <common.h>
+
+/* -------------------------------------------------------------------------- */
+/** @brief Create a new filter response cache 
+* 
+* @param size 
+* @return FiltCache
+*/
+/* ---------------------------------------------------------------------------- */
+FiltCache
+newFiltCache(int size) {
+  FiltCache c = (FiltCache) safealloc(1, sizeof(filt_cache), "filter cache");
+  c->size = size;
+  c->ent = (filt_cache_entry *) safealloc(size, sizeof(filt_cache_entry),
+					  "filter cache entries");
+  return c;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Empty a filter response cache 
+* 
+* @param c 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+resetFiltCache(FiltCache c) {
+  int i;
+  for (i = 0; i < c->size; i++) {
+    delvec_COMPLEX(c->ent[i].coef);
+    delvec_COMPLEX(c->ent[i].resp);
+  }
+  memset((char *) c->ent, 0, c->size * sizeof(filt_cache_entry));
+  c->clock = c->hits = c->misses = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Destroy a filter response cache 
+* 
+* @param c 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+delFiltCache(FiltCache c) {
+  if (c) {
+    resetFiltCache(c);
+    safefree((char *) c->ent);
+    safefree((char *) c);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Look up a designed filter 
+* 
+* hit counts as a use
+*
+* @param c 
+* @param lo 
+* @param hi 
+* @param rate 
+* @param ncoef 
+* @param window 
+* @param shape window parameter, Kaiser beta
+* @param minph minimum phase
+* @param f the filter the response is for
+* @return FiltCacheEntry, 0 if not there
+*/
+/* ---------------------------------------------------------------------------- */
+FiltCacheEntry
+FiltCache_lookup(FiltCache c,
+		 REAL lo, REAL hi, REAL rate,
+		 int ncoef, int window, REAL shape,
+		 BOOLEAN minph,
+		 FiltOvSv f) {
+  int i;
+  for (i = 0; i < c->size; i++) {
+    FiltCacheEntry e = &c->ent[i];
+    if (e->resp
+	&& e->lo == lo && e->hi == hi && e->rate == rate
+	&& e->ncoef == ncoef && e->window == window && e->shape == shape
+	&& e->minph == minph
+	&& e->buflen == f->buflen && e->npart == f->npart) {
+      e->used = ++c->clock;
+      c->hits++;
+      return e;
+    }
+  }
+  c->misses++;
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Put a designed filter in the cache 
+* 
+* over the least recently used entry
+*
+* @param c 
+* @param lo 
+* @param hi 
+* @param rate 
+* @param ncoef 
+* @param window 
+* @param shape window parameter, Kaiser beta
+* @param minph minimum phase
+* @param f the filter the response is for
+* @param coef ncoef taps
+* @param resp FiltOvSv_respsize(f) of response
+* @param scale normalization folded into resp
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+FiltCache_store(FiltCache c,
+		REAL lo, REAL hi, REAL rate,
+		int ncoef, int window, REAL shape,
+		BOOLEAN minph,
+		FiltOvSv f,
+		COMPLEX *coef,
+		COMPLEX *resp,
+		REAL scale) {
+  int i, n = FiltOvSv_respsize(f);
+  FiltCacheEntry e = &c->ent[0];
+
+  for (i = 1; i < c->size; i++)
+    if (c->ent[i].used < e->used)
+      e = &c->ent[i];
+
+  delvec_COMPLEX(e->coef);
+  delvec_COMPLEX(e->resp);
+
+  e->lo = lo, e->hi = hi, e->rate = rate;
+  e->ncoef = ncoef, e->window = window, e->shape = shape;
+  e->minph = minph;
+  e->buflen = f->buflen, e->npart = f->npart;
+  e->coef = newvec_COMPLEX(ncoef, "filter cache taps");
+  e->resp = newvec_COMPLEX(n, "filter cache response");
+  memcpy((char *) e->coef, (char *) coef, ncoef * sizeof(COMPLEX));
+  memcpy((char *) e->resp, (char *) resp, n * sizeof(COMPLEX));
+  e->scale = scale;
+  e->used = ++c->clock;
+}
@@ -0,0 +1,76 @@
+// filtcache.h
+/*
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 by the DttSP contributors
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _filtcache_h
+#define _filtcache_h
+
+#include <fromsys.h>
+#include <defs.h>
+#include <banal.h>
+#include <datatypes.h>
+#include <bufvec.h>
+#include <ovsv.h>
+
+/// designed filter responses, least recently used goes first.
+/// keyed by everything that goes into a bandpass design
+/// and the overlap/save geometry its response was made for.
+/// no locking; everyone who designs filters holds upd.
+
+#define FILTCACHE_SIZE (32)
+
+typedef struct _filt_cache_entry {
+  REAL lo, hi, rate;
+  int ncoef, window,
+      buflen, npart;
+  REAL shape;		// window parameter, 0 if it hasn't one
+  BOOLEAN minph;	// taps made minimum phase
+  COMPLEX *coef,	// taps
+          *resp;	// normalized response, all partitions
+  REAL scale;		// what normalizing took
+  unsigned long used;
+} filt_cache_entry, *FiltCacheEntry;
+
+typedef struct _filt_cache {
+  int size;
+  unsigned long clock,
+                hits, misses;
+  filt_cache_entry *ent;
+} filt_cache, *FiltCache;
+
+extern FiltCache newFiltCache(int size);
+extern void delFiltCache(FiltCache c);
+extern void resetFiltCache(FiltCache c);
+
+extern FiltCacheEntry FiltCache_lookup(FiltCache c,
+				       REAL lo, REAL hi, REAL rate,
+				       int ncoef, int window, REAL shape,
+				       BOOLEAN minph,
+				       FiltOvSv f);
+extern void FiltCache_store(FiltCache c,
+			    REAL lo, REAL hi, REAL rate,
+			    int ncoef, int window, REAL shape,
+			    BOOLEAN minph,
+			    FiltOvSv f,
+			    COMPLEX *coef,
+			    COMPLEX *resp,
+			    REAL scale);
+
+#endif
@@ -74,6 +74,16 @@ typedef struct _complex_FIR {
   struct { REAL lo, hi; } freq;
 } ComplexFIRDesc, *ComplexFIR;
 
+// what a design has to meet rather than how long it is
+
+typedef struct _fir_spec {
+  REAL ripple,	// passband, dB
+       atten,	// stopband, dB
+       trans;	// transition width, Hz; none if not positive
+  int size;	// what FIR_Kaiser_fit found it takes
+  REAL beta;
+} FIRSpecDesc, *FIRSpec;
+
 #define FIRcoef(p) ((p)->coef)
 #define FIRtap(p, i) (FIRcoef(p)[(i)])
 #define FIRsize(p) ((p)->size)
@@ -103,6 +113,12 @@ extern ComplexFIR newFIR_Lowpass_COMPLEX(REAL cutoff, REAL sr, int size);
 extern RealFIR newFIR_Bandpass_REAL(REAL lo, REAL hi, REAL sr, int size);
 extern ComplexFIR newFIR_Bandpass_COMPLEX(REAL lo, REAL hi, REAL sr,
 					  int size);
+extern ComplexFIR newFIR_Bandpass_Kaiser_COMPLEX(REAL lo, REAL hi, REAL sr,
+						 int size, REAL beta);
+extern ComplexFIR newFIR_Bandpass_Spec_COMPLEX(REAL lo, REAL hi, REAL sr,
+					       FIRSpec s, int most);
+extern int FIR_Kaiser_fit(FIRSpec s, REAL sr, int most);
+extern void FIR_MinPhase_COMPLEX(COMPLEX *coef, int size);
 extern RealFIR newFIR_Highpass_REAL(REAL cutoff, REAL sr, int size);
 extern ComplexFIR newFIR_Highpass_COMPLEX(REAL cutoff, REAL sr, int size);
 extern RealFIR newFIR_Hilbert_REAL(REAL lo, REAL hi, REAL sr, int size);
@@ -34,6 +34,10 @@ Bridgewater, NJ 08807
 #ifndef _fromsys_h
 #define _fromsys_h
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE	// for CPU affinity
+#endif
+
 #include <sys/types.h>
 #include <sys/param.h>
 #include <sys/stat.h>
@@ -50,6 +54,7 @@ Bridgewater, NJ 08807
 #include <time.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -73,10 +73,12 @@ new_EQ (CXB d, REAL samplerate, int pbits) {
   ComplexFIR BP;
   EQ a = (EQ) safealloc(1, sizeof (eq), "new eq state");
 
-  BP = newFIR_Bandpass_COMPLEX(-6000.0, 6000.0, samplerate, 257);
-  a->p = newFiltOvSv(BP->coef, 257, pbits);
+  BP = newFIR_Bandpass_COMPLEX(-6000.0, 6000.0, samplerate, EQ_TAPS);
+  a->p = newFiltOvSv(BP->coef, EQ_TAPS, pbits);
   a->in = newCXB(256, FiltOvSv_fetchpoint(a->p), "EQ input CXB");
   a->out = newCXB(256, FiltOvSv_storepoint(a->p), "EQ output CXB");
+  a->coef = newvec_COMPLEX(EQ_TAPS, "EQ taps");
+  memcpy((char *) a->coef, (char *) BP->coef, EQ_TAPS * sizeof(COMPLEX));
   a->data = d;
   delFIR_Bandpass_COMPLEX(BP);
   return a;
@@ -94,6 +96,7 @@ delEQ (EQ a) {
     delCXB(a->in);
     delCXB(a->out);
     delFiltOvSv (a->p);
+    delvec_COMPLEX(a->coef);
     safefree ((char *) a);
   }
 }
@@ -61,9 +61,12 @@ This is derived from equ.xmms:
 #include <filter.h>
 #include <fftw3.h>
 
+#define EQ_TAPS (257)
+
 typedef struct _eq {
   CXB data, in, out;
   FiltOvSv p;
+  COMPLEX *coef;	// EQ_TAPS, for folding into another filter
 } eq, *EQ;
 
 extern void graphiceq(EQ a);
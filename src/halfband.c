@@ -39,21 +39,28 @@ Bridgewater, NJ 08807
 #include <halfband.h>
 //------------------------------------------------------------------
 
+static void _bail(int);
+static void init_hb_filt(hb_filt_t *, int, int);
+static void fini_hb_filt(hb_filt_t *);
+
+//------------------------------------------------------------------
+
 /* -------------------------------------------------------------------------- */
 /** @brief Run a Half Band function 
 * 
+* full rate, output as long as the input
+*
 * @param h 
 * @return void
 */
 /* ---------------------------------------------------------------------------- */
 void
 HalfBandit(HalfBander h) {
-  int i;
-  for (i = 0; i < CXBhave(h->buf.i); i++)
-    CXBdata(h->buf.o, i) = Cmplx(hb_filt_proc(h->filt.gen.re,
-					      CXBreal(h->buf.i, i)),
-				 hb_filt_proc(h->filt.gen.im,
-					      CXBimag(h->buf.i, i)));
+  hb_filt_proc(h->filt.gen,
+	       CXBbase(h->buf.i),
+	       CXBbase(h->buf.o),
+	       CXBhave(h->buf.i));
+  CXBhave(h->buf.o) = CXBhave(h->buf.i);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -69,8 +76,7 @@ HalfBandit(HalfBander h) {
 HalfBander
 newHalfBander(int ord, BOOLEAN steep, CXB ibuf, CXB obuf) {
   HalfBander h = (HalfBander) safealloc(1, sizeof(HalfBandInfo), "HalfBander wrapper");
-  h->filt.gen.re = new_hb_filt(ord, steep);
-  h->filt.gen.im = new_hb_filt(ord, steep);
+  h->filt.gen = new_hb_filt(ord, steep);
   h->buf.i = newCXB(CXBsize(ibuf), CXBbase(ibuf), "HalfBander input");
   h->buf.o = newCXB(CXBsize(obuf), CXBbase(obuf), "HalfBander output");
   return h;
@@ -86,8 +92,7 @@ newHalfBander(int ord, BOOLEAN steep, CXB ibuf, CXB obuf) {
 void
 delHalfBander(HalfBander h) {
   if (h) {
-    del_hb_filt(h->filt.gen.re);
-    del_hb_filt(h->filt.gen.im);
+    del_hb_filt(h->filt.gen);
     delCXB(h->buf.i);
     delCXB(h->buf.o);
     safefree((char *) h);
@@ -96,162 +101,257 @@ delHalfBander(HalfBander h) {
 
 //------------------------------------------------------------------
 
-static void _bail(int);
-static char *_safealloc(int, int, int);
-static void _safefree(char *);
-
-//------------------------------------------------------------------
-//------------------------------------------------------------------
-
 /* -------------------------------------------------------------------------- */
-/** @brief Half bander filter process 
+/** @brief Create a 2^nstg half-band decimator or interpolator
 * 
-* @param this 
-* @param inp 
-* @return REAL
+* the same filter at every octave; the input length
+* has to be a multiple of 2^nstg for decimation
+*
+* @param nstg number of halvings or doublings
+* @param ord 
+* @param steep 
+* @param ibuf 
+* @param obuf 
+* @return HalfBandCascade
 */
 /* ---------------------------------------------------------------------------- */
-REAL
-hb_filt_proc(hb_filt_t *this, REAL inp) {
-  REAL out = (hb_ap_casc_proc(this->a, inp) + this->old) * 0.5;
-  this->old = hb_ap_casc_proc(this->b, inp);
-  return out;
+HalfBandCascade
+newHalfBandCascade(int nstg, int ord, BOOLEAN steep, CXB ibuf, CXB obuf) {
+  HalfBandCascade c = (HalfBandCascade) safealloc(1,
+						  sizeof(HalfBandCascadeInfo),
+						  "HalfBand cascade");
+  int k, most = max(CXBsize(ibuf), CXBsize(obuf));
+  c->nstg = nstg;
+  c->stg = (hb_filt_t *) safealloc(nstg, sizeof(hb_filt_t), "HalfBand cascade stages");
+  for (k = 0; k < nstg; k++)
+    init_hb_filt(&c->stg[k], ord, steep);
+  c->work[0] = newvec_COMPLEX(most, "HalfBand cascade work");
+  c->work[1] = newvec_COMPLEX(most, "HalfBand cascade work");
+  c->buf.i = newCXB(CXBsize(ibuf), CXBbase(ibuf), "HalfBand cascade input");
+  c->buf.o = newCXB(CXBsize(obuf), CXBbase(obuf), "HalfBand cascade output");
+  return c;
 }
 
-//..................................................................
-
 /* -------------------------------------------------------------------------- */
-/** @brief _hb_ap_proc 
+/** @brief Decimate by 2^nstg
+*
+* the first stage reads the input, the rest halve
+* the work buffer in place, the last lands in the output
 * 
-* @param this 
-* @param inp 
-* @return REAL
+* @param c 
+* @return void
 */
 /* ---------------------------------------------------------------------------- */
-static inline REAL
-_hb_ap_proc(hb_ap_t *this, REAL inp) {
-  this->x[2] = this->x[1], this->x[1] = this->x[0], this->x[0] = inp;
-  this->y[2] = this->y[1], this->y[1] = this->y[0],
-    this->y[0] = this->x[2] + (this->c * (inp - this->y[2]));
-  return this->y[0];
+void
+HalfBandDecimate(HalfBandCascade c) {
+  int k, n = CXBhave(c->buf.i);
+  COMPLEX *src = CXBbase(c->buf.i);
+  for (k = 0; k < c->nstg; k++) {
+    COMPLEX *dst = k == c->nstg - 1 ? CXBbase(c->buf.o) : c->work[0];
+    hb_filt_decim(&c->stg[k], src, dst, n);
+    src = dst, n /= 2;
+  }
+  CXBhave(c->buf.o) = n;
 }
 
-//..................................................................
-
 /* -------------------------------------------------------------------------- */
-/** @brief hb_ap_casc_proc 
+/** @brief Interpolate by 2^nstg
+*
+* doubling can't run in place, so stages alternate
+* between the work buffers
 * 
-* @param this 
-* @param inp 
-* @return REAL
+* @param c 
+* @return void
 */
 /* ---------------------------------------------------------------------------- */
-REAL
-hb_ap_casc_proc(hb_ap_casc_t *this, REAL inp) {
-  int i;
-  REAL out = inp;
-  for (i = 0; i < this->numf; i++) out = _hb_ap_proc(this->apf[i], out);
-  return out;
+void
+HalfBandInterpolate(HalfBandCascade c) {
+  int k, n = CXBhave(c->buf.i);
+  COMPLEX *src = CXBbase(c->buf.i);
+  for (k = 0; k < c->nstg; k++) {
+    COMPLEX *dst = c->work[k & 1];
+    if (k == c->nstg - 1 && src != CXBbase(c->buf.o))
+      dst = CXBbase(c->buf.o);
+    hb_filt_interp(&c->stg[k], src, dst, n);
+    src = dst, n *= 2;
+  }
+  if (src != CXBbase(c->buf.o))
+    memcpy((char *) CXBbase(c->buf.o), (char *) src, n * sizeof(COMPLEX));
+  CXBhave(c->buf.o) = n;
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief hb_ap_proc 
+/** @brief Destroy a half-band cascade
 * 
-* @param this 
-* @param inp 
-* @return REAL
+* @param c 
+* @return void
 */
 /* ---------------------------------------------------------------------------- */
-REAL
-hb_ap_proc(hb_ap_t *this, REAL inp) {
-  this->x[2] = this->x[1], this->x[1] = this->x[0], this->x[0] = inp;
-  this->y[2] = this->y[1], this->y[1] = this->y[0],
-    this->y[0] = this->x[2] + (this->c * (inp - this->y[2]));
-  return this->y[0];
+void
+delHalfBandCascade(HalfBandCascade c) {
+  if (c) {
+    int k;
+    for (k = 0; k < c->nstg; k++)
+      fini_hb_filt(&c->stg[k]);
+    safefree((char *) c->stg);
+    delvec_COMPLEX(c->work[0]);
+    delvec_COMPLEX(c->work[1]);
+    delCXB(c->buf.i);
+    delCXB(c->buf.o);
+    safefree((char *) c);
+  }
 }
 
 //------------------------------------------------------------------
 //------------------------------------------------------------------
 
 /* -------------------------------------------------------------------------- */
-/** @brief new_hb_ap 
+/** @brief _hb_step
+*
+* one sample through every section: v is (re, im) for branch a,
+* then (re, im) for branch b, and comes back filtered
 * 
-* @param coef 
-* @return hb_ap_t *
+* @param this 
+* @param z state for this input phase
+* @param v 
+* @return void
 */
 /* ---------------------------------------------------------------------------- */
-hb_ap_t *
-new_hb_ap(REAL coef) {
-  hb_ap_t *this = (hb_ap_t *) _safealloc(1, sizeof(hb_ap_t), __LINE__);
-  this->c = coef;
-  return this;
+static inline void
+_hb_step(hb_filt_t *this, REAL *z, REAL *v) {
+  int k;
+#ifdef __SSE3__
+  __m128 x = _mm_loadu_ps(v);
+  for (k = 0; k < this->numf; k++, z += 8) {
+    __m128 y = _mm_add_ps(_mm_load_ps(z),
+			  _mm_mul_ps(_mm_load_ps(this->c + 4 * k),
+				     _mm_sub_ps(x, _mm_load_ps(z + 4))));
+    _mm_store_ps(z, x);
+    _mm_store_ps(z + 4, y);
+    x = y;
+  }
+  _mm_storeu_ps(v, x);
+#else
+  for (k = 0; k < this->numf; k++, z += 8) {
+    int j;
+    for (j = 0; j < 4; j++) {
+      REAL y = z[j] + this->c[4 * k + j] * (v[j] - z[4 + j]);
+      z[j] = v[j], z[4 + j] = y, v[j] = y;
+    }
+  }
+#endif
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief del_hb_ap 
+/** @brief Half bander filter process 
+*
+* full rate. Branch a on sample n and branch b on sample n-1
+* only ever see every other input, so each runs as a plain
+* allpass at half rate, with one state set per input phase
 * 
 * @param this 
-* @param  
-* @param this 
+* @param inp 
+* @param out may be inp
+* @param n 
 * @return void
 */
 /* ---------------------------------------------------------------------------- */
 void
-del_hb_ap(hb_ap_t *this) { _safefree((char *) this); }
-
-//------------------------------------------------------------------
+hb_filt_proc(hb_filt_t *this, COMPLEX *inp, COMPLEX *out, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    REAL v[4] = { inp[i].re, inp[i].im, this->old.re, this->old.im };
+    this->old = inp[i];
+    _hb_step(this, this->z[this->phase], v);
+    this->phase ^= 1;
+    out[i] = Cmplx((REAL) 0.5 * (v[0] + v[2]), (IMAG) 0.5 * (v[1] + v[3]));
+  }
+}
 
 /* -------------------------------------------------------------------------- */
-/** @brief bh_ap_casc_t 
+/** @brief Half bander decimate by 2
+*
+* the even outputs of hb_filt_proc, computing only those
 * 
-* @param coef 
-* @param n 
-* @return hb_ap_casc_t *
+* @param this 
+* @param inp n samples, n even
+* @param out n/2 samples, may be inp
+* @return void
 */
 /* ---------------------------------------------------------------------------- */
-hb_ap_casc_t *
-new_hb_ap_casc(REAL *coef, int n) {
-  hb_ap_casc_t *this = (hb_ap_casc_t *) _safealloc(1,
-						   sizeof(hb_ap_casc_t),
-						   __LINE__);
-  this->numf = n;
-  this->apf = (hb_ap_t **) _safealloc(this->numf, sizeof(hb_ap_t *), __LINE__);
-  {
-    int i;
-    for (i = 0; i < this->numf; i++) this->apf[i] = new_hb_ap(coef[i]);
+void
+hb_filt_decim(hb_filt_t *this, COMPLEX *inp, COMPLEX *out, int n) {
+  int i;
+  for (i = 0; i < n / 2; i++) {
+    REAL v[4] = { inp[2 * i].re, inp[2 * i].im, this->old.re, this->old.im };
+    this->old = inp[2 * i + 1];
+    _hb_step(this, this->z[0], v);
+    out[i] = Cmplx((REAL) 0.5 * (v[0] + v[2]), (IMAG) 0.5 * (v[1] + v[3]));
   }
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief del_hb_ap_casc 
+/** @brief Half bander interpolate by 2
+*
+* with zeros stuffed in between, branch a makes the even
+* outputs and branch b the odd ones, from the same input
 * 
 * @param this 
+* @param inp n samples
+* @param out 2n samples, not inp
 * @return void
 */
 /* ---------------------------------------------------------------------------- */
 void
-del_hb_ap_casc(hb_ap_casc_t *this) {
-  if (this) {
-    int i;
-    for (i = 0; i < this->numf; i++) del_hb_ap(this->apf[i]);
-    _safefree(( char*) this->apf);
-    _safefree((char *) this);
+hb_filt_interp(hb_filt_t *this, COMPLEX *inp, COMPLEX *out, int n) {
+  int i;
+  for (i = 0; i < n; i++) {
+    REAL v[4] = { inp[i].re, inp[i].im, inp[i].re, inp[i].im };
+    _hb_step(this, this->z[0], v);
+    out[2 * i] = Cmplx(v[0], v[1]);
+    out[2 * i + 1] = Cmplx(v[2], v[3]);
   }
 }
 
 //------------------------------------------------------------------
 
 /* -------------------------------------------------------------------------- */
-/** @brief new_hb_filt 
+/** @brief hb_load
+* 
+* lay the two branches out in quads, one per section
+*
+* @param this 
+* @param a 
+* @param b 
+* @param n sections per branch
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+static void
+hb_load(hb_filt_t *this, REAL *a, REAL *b, int n) {
+  int k;
+  this->numf = n;
+  this->c = newvec_REAL(4 * n, "half band coefficients");
+  this->z[0] = newvec_REAL(8 * n, "half band state");
+  this->z[1] = newvec_REAL(8 * n, "half band state");
+  for (k = 0; k < n; k++)
+    this->c[4 * k] = this->c[4 * k + 1] = a[k],
+    this->c[4 * k + 2] = this->c[4 * k + 3] = b[k];
+}
+
+//------------------------------------------------------------------
+
+/* -------------------------------------------------------------------------- */
+/** @brief init_hb_filt 
 * 
+* @param this 
 * @param ord 
 * @param steep 
-* @return hb_filt_t
+* @return void
 */
 /* ---------------------------------------------------------------------------- */
-hb_filt_t *
-new_hb_filt(int ord, int steep) {
-  hb_filt_t *this= (hb_filt_t *) _safealloc(1,sizeof(hb_filt_t),__LINE__);
+static void
+init_hb_filt(hb_filt_t *this, int ord, int steep) {
 
   if (steep) {
 
@@ -276,8 +376,7 @@ new_hb_filt(int ord, int steep) {
 	0.987816370732897100
       };
 
-      this->a = new_hb_ap_casc(a, 6);
-      this->b = new_hb_ap_casc(b, 6);
+      hb_load(this, a, b, 6);
       break;
     }
 
@@ -298,8 +397,7 @@ new_hb_filt(int ord, int steep) {
 	0.98547502301490700
       };
 	  
-      this->a = new_hb_ap_casc(a, 5);
-      this->b = new_hb_ap_casc(b, 5);
+      hb_load(this, a, b, 5);
       break;
     }
 
@@ -318,8 +416,7 @@ new_hb_filt(int ord, int steep) {
 	0.9820054141886075
       };
 	  
-      this->a = new_hb_ap_casc(a, 4);
-      this->b = new_hb_ap_casc(b, 4);
+      hb_load(this, a, b, 4);
       break;
     }
 
@@ -336,8 +433,7 @@ new_hb_filt(int ord, int steep) {
 	0.97631145158367730
       };
       
-      this->a = new_hb_ap_casc(a, 3);
-      this->b = new_hb_ap_casc(b, 3);
+      hb_load(this, a, b, 3);
       break;
     }
 
@@ -352,8 +448,7 @@ new_hb_filt(int ord, int steep) {
 	0.8907868326534970
       };
 
-      this->a = new_hb_ap_casc(a, 2);
-      this->b = new_hb_ap_casc(b, 2);
+      hb_load(this, a, b, 2);
       break;
     }
 
@@ -362,8 +457,7 @@ new_hb_filt(int ord, int steep) {
       REAL a[1] = { 0.23647102099689224 };
       REAL b[1] = { 0.71454214971260010 };
 
-      this->a = new_hb_ap_casc(a, 1);
-      this->b = new_hb_ap_casc(b, 1);
+      hb_load(this, a, b, 1);
       break;
     }
 
@@ -394,8 +488,7 @@ new_hb_filt(int ord, int steep) {
 	0.95996874048006940
       };
 
-      this->a = new_hb_ap_casc(a, 6);
-      this->b = new_hb_ap_casc(b, 6);
+      hb_load(this, a, b, 6);
       break;
     }
 
@@ -416,8 +509,7 @@ new_hb_filt(int ord, int steep) {
 	0.95247728378667541
       };
 
-      this->a = new_hb_ap_casc(a, 5);
-      this->b = new_hb_ap_casc(b, 5);
+      hb_load(this, a, b, 5);
       break;
     }
 
@@ -436,8 +528,7 @@ new_hb_filt(int ord, int steep) {
 	0.9415030941737551
       };
 	  
-      this->a = new_hb_ap_casc(a, 4);
-      this->b = new_hb_ap_casc(b, 4);
+      hb_load(this, a, b, 4);
       break;
     }
 
@@ -454,8 +545,7 @@ new_hb_filt(int ord, int steep) {
 	0.9238861386532906
       };
 
-      this->a = new_hb_ap_casc(a, 3);
-      this->b = new_hb_ap_casc(b, 3);
+      hb_load(this, a, b, 3);
       break;
     }
 
@@ -470,8 +560,7 @@ new_hb_filt(int ord, int steep) {
 	0.83441189148073790
       };
 
-      this->a = new_hb_ap_casc(a, 2);
-      this->b = new_hb_ap_casc(b, 2);
+      hb_load(this, a, b, 2);
       break;
     }
 
@@ -480,8 +569,7 @@ new_hb_filt(int ord, int steep) {
       REAL a[1] = { 0.23647102099689224 };
       REAL b[1] = { 0.71454214971260010 };
 
-      this->a = new_hb_ap_casc(a, 1);
-      this->b = new_hb_ap_casc(b, 1);
+      hb_load(this, a, b, 1);
       break;
     }
 
@@ -490,11 +578,39 @@ new_hb_filt(int ord, int steep) {
     }
   }
 
-  this->old = 0.0;
+  this->old = cxzero;
+  this->phase = 0;
+}
 
+/* -------------------------------------------------------------------------- */
+/** @brief new_hb_filt 
+* 
+* @param ord 
+* @param steep 
+* @return hb_filt_t
+*/
+/* ---------------------------------------------------------------------------- */
+hb_filt_t *
+new_hb_filt(int ord, int steep) {
+  hb_filt_t *this = (hb_filt_t *) safealloc(1, sizeof(hb_filt_t), "half band filter");
+  init_hb_filt(this, ord, steep);
   return this;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief fini_hb_filt 
+* 
+* @param this 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+static void
+fini_hb_filt(hb_filt_t *this) {
+  delvec_REAL(this->c);
+  delvec_REAL(this->z[0]);
+  delvec_REAL(this->z[1]);
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief del_hb_filt 
 * 
@@ -504,9 +620,10 @@ new_hb_filt(int ord, int steep) {
 /* ---------------------------------------------------------------------------- */
 void
 del_hb_filt(hb_filt_t *this) {
-  del_hb_ap_casc(this->a);
-  del_hb_ap_casc(this->b);
-  _safefree((char *) this);
+  if (this) {
+    fini_hb_filt(this);
+    safefree((char *) this);
+  }
 }
 
 //------------------------------------------------------------------
@@ -523,31 +640,3 @@ _bail(int where) {
   fprintf(stderr, "halfband _bailed at line %d\n", where);
   exit(1);
 }
-
-/* -------------------------------------------------------------------------- */
-/** @brief _safealloc
-* 
-* @param num 
-* @param size 
-* @param where 
-* @return *char
-*/
-/* ---------------------------------------------------------------------------- */
-static char *
-_safealloc(int num, int size, int where) {
-  char *p = calloc(num, size);
-  if (!p) _bail(where);
-  return p;
-}
-
-/* -------------------------------------------------------------------------- */
-/** @brief _safefree 
-* 
-* @param p 
-* @param if(p 
-* @param free(p 
-* @return void
-*/
-/* ---------------------------------------------------------------------------- */
-static void
-_safefree(char *p) { if (p) free(p); }
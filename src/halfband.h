@@ -69,47 +69,39 @@ Canada
 
 #include <datatypes.h>
 #include <complex.h>
-#include <bufvec.h>			   
+#include <bufvec.h>
+#include <cxops.h>			   
 			   
 //==================================================================
 
-typedef
-struct hb_ap {
-  REAL c, x[3], y[3];
-} hb_ap_t;
-
-typedef
-struct hb_ap_casc {
-  int numf;
-  hb_ap_t **apf;
-} hb_ap_casc_t;
+// two allpass branches in z^2, a on the current sample and b on the one
+// before, averaged. Sections are stored flat, one quad per section
+// (a, a, b, b), so re and im of both branches go through in one
+// SIMD step.
 
 typedef
 struct hb_filt {
-  hb_ap_casc_t *a, *b;
-  REAL old;
+  int numf;		// sections per branch
+  REAL *c,		// numf quads of coefficients
+       *z[2];		// numf quads of past inputs, numf of past outputs,
+			// for each input phase
+  COMPLEX old;		// previous input
+  int phase;
 } hb_filt_t;
 
-REAL hb_ap_proc(hb_ap_t *, REAL);
-hb_ap_t *new_hb_ap(REAL coefficient);
-void del_hb_ap(hb_ap_t *);
+extern hb_filt_t *new_hb_filt(int ord, int steep);
+extern void del_hb_filt(hb_filt_t *);
 
-REAL hb_ap_casc_proc(hb_ap_casc_t *, REAL);
-hb_ap_casc_t *new_hb_ap_casc(REAL *, int);
-void del_hp_ap_casc(hb_ap_casc_t *);
-
-REAL hb_filt_proc(hb_filt_t *, REAL);
-hb_filt_t *new_hb_filt(int, int);
-void del_hb_filt(hb_filt_t *);
+extern void hb_filt_proc(hb_filt_t *, COMPLEX *, COMPLEX *, int);
+extern void hb_filt_decim(hb_filt_t *, COMPLEX *, COMPLEX *, int);
+extern void hb_filt_interp(hb_filt_t *, COMPLEX *, COMPLEX *, int);
 
 //==================================================================
 
 typedef
 struct _half_band {
   struct {
-    struct {
-      hb_filt_t *re, *im;
-    } gen;
+    hb_filt_t *gen;
   } filt;
   struct {
     CXB i, o;
@@ -120,4 +112,27 @@ extern void HalfBandit(HalfBander h);
 extern HalfBander newHalfBander(int ord, BOOLEAN steep, CXB ibuf, CXB obuf);
 extern void delHalfBander(HalfBander h);
 
+//==================================================================
+
+// 2^nstg down or up, one half-band per octave
+
+typedef
+struct _half_band_cascade {
+  int nstg;
+  hb_filt_t *stg;	// nstg of them, contiguous
+  COMPLEX *work[2];
+  struct {
+    CXB i, o;
+  } buf;
+} HalfBandCascadeInfo, *HalfBandCascade;
+
+extern HalfBandCascade newHalfBandCascade(int nstg,
+					  int ord,
+					  BOOLEAN steep,
+					  CXB ibuf,
+					  CXB obuf);
+extern void HalfBandDecimate(HalfBandCascade c);
+extern void HalfBandInterpolate(HalfBandCascade c);
+extern void delHalfBandCascade(HalfBandCascade c);
+
 #endif
@@ -50,19 +50,31 @@ extern struct _loc {
   struct {
     char rcfile[MAXPATHLEN],
          echo[MAXPATHLEN],
+         input[MAXPATHLEN],
          meter[MAXPATHLEN],
+         output[MAXPATHLEN],
          replay[MAXPATHLEN],
          spec[MAXPATHLEN],
          wisdom[MAXPATHLEN];
   } path;
   struct {
     REAL rate, chan;
-    int size, bufl, nrx, spec, comp;
+    int size, bufl, nrx, spec, comp,
+        dec;	// rx decimation after the filter
     SDRMODE mode;
   } def;
   struct {
     int ring;
   } mult;
+  struct {
+    BOOLEAN rx;
+  } par;
+  struct {
+    struct {
+      int prio, cpu;	// SCHED_FIFO priority, 0 leaves it alone; cpu -1 floats
+    } trx, upd, mtr, pws, rxw;
+    BOOLEAN lock;
+  } rt;
   struct {
     int offs;
   } skew;
@@ -159,3 +159,23 @@ delOSC(OSC p) {
   if (p)
     safefree((char *) p);
 }
+
+/* -------------------------------------------------------------------------- */
+/** @brief Put an oscillator on a new output buffer 
+* 
+* for buffer length changes; phase and frequency carry on
+* where they were. Hands back the old buffer for freeing.
+*
+* @param p 
+* @param buf CXB or RLB to match the oscillator type 
+* @param size 
+* @return void * old buffer
+*/
+/* ---------------------------------------------------------------------------- */
+void *
+resizeOSC(OSC p, void *buf, int size) {
+  void *old = OSCbase(p);
+  OSCbase(p) = buf;
+  OSCsize(p) = size;
+  return old;
+}
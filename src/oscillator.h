@@ -73,5 +73,6 @@ extern OSC newOSC(int size, OscType TypeOsc, double Frequency,
 		  double Phase, REAL SampleRate, char *tag);
 extern void delOSC(OSC);
 extern void fixOSC(OSC p, double Frequency, double Phase, REAL SampleRate);
+extern void *resizeOSC(OSC p, void *buf, int size);
 
 #endif
@@ -40,6 +40,106 @@ Bridgewater, NJ 08807
 
 /*------------------------------------------------------------*/
 
+/* -------------------------------------------------------------------------- */
+/** @brief private convolve 
+*
+* input spectrum times response, into zivec.
+* Single partition works in place on zivec unless zx says otherwise;
+* partitioned sums over the delay line.
+*
+* @param pflt 
+* @param zfvec 
+* @param zx 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+convolve(FiltOvSv pflt, COMPLEX *zfvec, COMPLEX *zx) {
+  int m = pflt->fftlen;
+  COMPLEX *zivec = pflt->zivec;
+#ifndef __SSE3__
+  int i;
+#endif
+
+  if (pflt->npart > 1) {
+    /* sum each partition against its own past block */
+    int p, P = pflt->npart, t = pflt->fdl;
+    COMPLEX *zdvec = pflt->zdvec;
+
+#ifdef __SSE3__
+    CmulSSE3(zivec, &zdvec[t * m], zfvec, m);
+    for (p = 1; p < P; p++)
+      CmacSSE3(zivec, &zdvec[((t - p + P) % P) * m], &zfvec[p * m], m);
+#else
+    for (i = 0; i < m; i++)
+      zivec[i] = Cmul(zdvec[t * m + i], zfvec[i]);
+    for (p = 1; p < P; p++) {
+      COMPLEX *x = &zdvec[((t - p + P) % P) * m],
+	      *h = &zfvec[p * m];
+      for (i = 0; i < m; i++)
+	zivec[i] = Cadd(zivec[i], Cmul(x[i], h[i]));
+    }
+#endif
+  } else {
+#ifdef __SSE3__
+    CmulSSE3(zivec, zx, zfvec, m);
+#else
+    /* convolve in z */
+    for (i = 0; i < m; i++)
+      zivec[i] = Cmul(zx[i], zfvec[i]);
+#endif
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private swap_resp 
+*
+* put the staged response in, optionally running old and new
+* side by side for this one block and crossfading between them
+*
+* @param pflt 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+swap_resp(FiltOvSv pflt) {
+  int i, m = pflt->fftlen, n = pflt->buflen;
+  COMPLEX *zx = pflt->zivec,
+          *zold = &pflt->zsvec[m];
+
+  if (pflt->fade) {
+    if (pflt->npart == 1)
+      memcpy((char *) pflt->zsvec, (char *) pflt->zivec, m * sizeof(COMPLEX)),
+      zx = pflt->zsvec;
+    convolve(pflt, pflt->zfvec, zx);
+    fftwf_execute(pflt->pinv);
+    memcpy((char *) zold, (char *) pflt->zovec, n * sizeof(COMPLEX));
+  }
+
+  {
+    COMPLEX *z = pflt->zfvec;
+    pflt->zfvec = pflt->zfnew, pflt->zfnew = z;
+  }
+  /* old response is no longer looked at, designer may have it */
+  __sync_synchronize();
+  pflt->stage = OVSV_IDLE;
+
+  convolve(pflt, pflt->zfvec, zx);
+  fftwf_execute(pflt->pinv);
+
+  if (pflt->fade) {
+    REAL scl = pflt->scale, w = 1.0 / n;
+    for (i = 0; i < n; i++) {
+      REAL a = i * w;
+      pflt->zovec[i] = Cscl(Cadd(Cscl(pflt->zovec[i], a),
+				 Cscl(zold[i], 1.0 - a)),
+			    scl);
+    }
+  } else
+    for (i = 0; i < n; i++)
+      pflt->zovec[i] = Cscl(pflt->zovec[i], pflt->scale);
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief Run OvSV filter
  *
@@ -52,28 +152,36 @@ Bridgewater, NJ 08807
 void
 filter_OvSv(FiltOvSv pflt) {
   int i, m = pflt->fftlen, n = pflt->buflen;
-  COMPLEX *zfvec = pflt->zfvec,
-          *zivec = pflt->zivec,
-          *zovec = pflt->zovec,
+  COMPLEX *zovec = pflt->zovec,
           *zrvec = pflt->zrvec;
   REAL scl = pflt->scale;
 
   /* input sig -> z */
   fftwf_execute(pflt->pfwd);
 
-#ifdef __SSE3__
-  CmulSSE3(zivec, zivec, zfvec, m);
-#else
-  /* convolve in z */
-  for (i = 0; i < m; i++)
-    zivec[i] = Cmul(zivec[i], zfvec[i]);
-#endif
-  /* z convolved sig -> time output sig */
-  fftwf_execute(pflt->pinv);
+  /* partitioned: newest spectrum into the delay line */
+  if (pflt->npart > 1)
+    memcpy((char *) &pflt->zdvec[pflt->fdl * m],
+	   (char *) pflt->zivec,
+	   m * sizeof(COMPLEX));
+
+  if (pflt->stage == OVSV_READY &&
+      __sync_bool_compare_and_swap(&pflt->stage, OVSV_READY, OVSV_SWAP))
+    swap_resp(pflt);
+
+  else {
+    convolve(pflt, pflt->zfvec, pflt->zivec);
 
-  /* scale */
-  for (i = 0; i < n; i++)
-    zovec[i].re *= scl, zovec[i].im *= scl;
+    /* z convolved sig -> time output sig */
+    fftwf_execute(pflt->pinv);
+
+    /* scale */
+    for (i = 0; i < n; i++)
+      zovec[i].re *= scl, zovec[i].im *= scl;
+  }
+
+  if (pflt->npart > 1)
+    pflt->fdl = (pflt->fdl + 1) % pflt->npart;
 
   /* prepare input sig vec for next fill */
   memcpy((char *) zrvec, (char *) &zrvec[n], n * sizeof(COMPLEX));
@@ -89,6 +197,10 @@ filter_OvSv(FiltOvSv pflt) {
 void
 reset_OvSv(FiltOvSv pflt) {
   memset((char *) pflt->zrvec, 0, pflt->fftlen * sizeof(COMPLEX));
+  if (pflt->zdvec)
+    memset((char *) pflt->zdvec, 0,
+	   pflt->npart * pflt->fftlen * sizeof(COMPLEX));
+  pflt->fdl = 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -199,7 +311,8 @@ FiltOvSv_storesize(FiltOvSv pflt) {
 /* -------------------------------------------------------------------------- */
 /** @brief Create a new OvSv filter 
 * 
-* create a new overlap/save filter from complex coefficients 
+* create a new overlap/save filter from complex coefficients,
+* block size fixed by the filter length
 *
 * @param coefs 
 * @param ncoef 
@@ -209,46 +322,58 @@ FiltOvSv_storesize(FiltOvSv pflt) {
 /* ---------------------------------------------------------------------------- */
 FiltOvSv
 newFiltOvSv(COMPLEX *coefs, int ncoef, int pbits) {
-  int buflen, fftlen;
+  return newFiltOvSvPart(coefs, ncoef, nblock2(ncoef - 1), pbits);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Partitions an OvSv filter needs 
+* 
+* @param ncoef 
+* @param buflen 
+* @return int
+*/
+/* ---------------------------------------------------------------------------- */
+int
+FiltOvSv_npart(int ncoef, int buflen) {
+  return ncoef <= buflen + 1 ? 1 : (ncoef + buflen - 1) / buflen;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Create a new partitioned OvSv filter 
+* 
+* block size buflen independent of the filter length.
+* Up to buflen + 1 taps it's the plain overlap/save filter.
+* Longer filters are cut into npart partitions of buflen taps,
+* each with its own response; past input spectra sit in a
+* frequency-domain delay line, so latency stays at one block
+* and the cost grows by one complex multiply-add per partition.
+*
+* @param coefs 
+* @param ncoef 
+* @param buflen 
+* @param pbits 
+* @return FiltOvSv
+*/
+/* ---------------------------------------------------------------------------- */
+FiltOvSv
+newFiltOvSvPart(COMPLEX *coefs, int ncoef, int buflen, int pbits) {
+  int fftlen, npart;
   FiltOvSv p;
   fftwf_plan pfwd, pinv;
-  COMPLEX *zrvec, *zfvec, *zivec, *zovec;
+  COMPLEX *zrvec, *zfvec, *zivec, *zovec, *zdvec = 0;
   
   p = (FiltOvSv) safealloc(1, sizeof(filt_ov_sv), "new overlap/save filter");
-  buflen = nblock2(ncoef - 1);
   fftlen = 2 * buflen;
+  npart = FiltOvSv_npart(ncoef, buflen);
 
   zrvec = newvec_COMPLEX_fftw(fftlen, "raw signal vec in newFiltOvSv");
-  zfvec = newvec_COMPLEX_fftw(fftlen, "filter z vec in newFiltOvSv");
+  zfvec = newvec_COMPLEX_fftw(npart * fftlen, "filter z vec in newFiltOvSv");
   zivec = newvec_COMPLEX_fftw(fftlen, "signal in z vec in newFiltOvSv");
   zovec = newvec_COMPLEX_fftw(fftlen, "signal out z vec in newFiltOvSv");
-
-  /* prepare frequency response from filter coefs */
-  {
-    int i;
-    COMPLEX *zcvec;
-    fftwf_plan ptmp;
-
-    zcvec = newvec_COMPLEX(fftlen, "temp filter z vec in newFiltOvSv");
-    ptmp =
-      fftwf_plan_dft_1d(fftlen,
-			(fftwf_complex *) zcvec,
-			(fftwf_complex *) zfvec,
-			FFTW_FORWARD,
-			pbits);
-
-#ifdef LHS
-    for (i = 0; i < ncoef; i++)
-      zcvec[i] = coefs[i];
-#else
-    for (i = 0; i < ncoef; i++)
-      zcvec[fftlen - ncoef + i] = coefs[i];
-#endif
-
-    fftwf_execute(ptmp);
-    fftwf_destroy_plan(ptmp);
-    delvec_COMPLEX(zcvec);
-  }
+  if (npart > 1)
+    zdvec = newvec_COMPLEX_fftw(npart * fftlen, "delay line in newFiltOvSv");
+  p->zfnew = newvec_COMPLEX_fftw(npart * fftlen, "spare filter z vec in newFiltOvSv");
+  p->zsvec = newvec_COMPLEX_fftw(fftlen + buflen, "scratch vec in newFiltOvSv");
 
   /* prepare transforms for signal */
   pfwd = fftwf_plan_dft_1d(fftlen,
@@ -264,17 +389,250 @@ newFiltOvSv(COMPLEX *coefs, int ncoef, int pbits) {
   /* stuff values */
   p->buflen = buflen;
   p->fftlen = fftlen;
+  p->npart = npart;
+  p->fdl = 0;
   p->zfvec = zfvec;
   p->zivec = zivec;
   p->zovec = zovec;
   p->zrvec = zrvec;
+  p->zdvec = zdvec;
+  p->stage = OVSV_IDLE;
+  p->fade = FALSE;
   p->pfwd = pfwd;
   p->pinv = pinv;
   p->scale = 1.0 / (REAL) fftlen;
 
+  /* prepare frequency response from filter coefs,
+     or leave it to the caller */
+  if (coefs)
+    load_OvSv(p, coefs, ncoef, pbits);
+
   return p;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief Load filter coefficients into an OvSv filter 
+* 
+* new frequency response for an existing filter, in place;
+* ncoef no more than the filter was made for, short sets are zero-padded
+*
+* @param pflt 
+* @param coefs 
+* @param ncoef 
+* @param pbits 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+load_OvSv(FiltOvSv pflt, COMPLEX *coefs, int ncoef, int pbits) {
+  loadresp_OvSv(pflt, pflt->zfvec, coefs, ncoef, pbits);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Compute an OvSv filter response 
+* 
+* into z, which holds FiltOvSv_respsize() COMPLEX
+*
+* @param pflt 
+* @param z 
+* @param coefs 
+* @param ncoef 
+* @param pbits 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+loadresp_OvSv(FiltOvSv pflt, COMPLEX *z, COMPLEX *coefs, int ncoef, int pbits) {
+  int i, j, n = pflt->buflen, m = pflt->fftlen;
+  COMPLEX *zcvec;
+  fftwf_plan ptmp;
+
+  zcvec = newvec_COMPLEX(m, "temp filter z vec in load_OvSv");
+  ptmp = fftwf_plan_dft_1d(m,
+			   (fftwf_complex *) zcvec,
+			   (fftwf_complex *) z,
+			   FFTW_FORWARD,
+			   pbits);
+
+  if (pflt->npart == 1) {
+    ncoef = min(ncoef, n + 1);
+#ifdef LHS
+    for (i = 0; i < ncoef; i++)
+      zcvec[i] = coefs[i];
+#else
+    for (i = 0; i < ncoef; i++)
+      zcvec[m - ncoef + i] = coefs[i];
+#endif
+    fftwf_execute(ptmp);
+
+  } else {
+    int p;
+
+    ncoef = min(ncoef, pflt->npart * n);
+    for (p = 0; p < pflt->npart; p++) {
+      memset((char *) zcvec, 0, m * sizeof(COMPLEX));
+      /* partition p holds taps p*n .. p*n + n - 1 */
+      for (i = 0, j = p * n; i < n && j < ncoef; i++, j++)
+#ifdef LHS
+	zcvec[i] = coefs[j];
+#else
+	zcvec[n + i] = coefs[j];
+#endif
+      fftwf_execute_dft(ptmp,
+			(fftwf_complex *) zcvec,
+			(fftwf_complex *) &z[p * m]);
+    }
+  }
+
+  fftwf_destroy_plan(ptmp);
+  delvec_COMPLEX(zcvec);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Normalize an OvSv filter response 
+* 
+* peak gain to unity
+*
+* @param pflt 
+* @return REAL scale applied
+*/
+/* ---------------------------------------------------------------------------- */
+REAL
+normalize_OvSv(FiltOvSv pflt) {
+  return normresp_OvSv(pflt, pflt->zfvec);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Normalize a response for an OvSv filter 
+* 
+* Partitions are n apart on a 2n grid,
+* so bin k of the whole filter is the partition responses
+* summed with alternating sign by partition parity.
+*
+* @param pflt 
+* @param z 
+* @return REAL scale applied, 0 for an all-zero response
+*/
+/* ---------------------------------------------------------------------------- */
+REAL
+normresp_OvSv(FiltOvSv pflt, COMPLEX *z) {
+  int i, p, m = pflt->fftlen, P = pflt->npart;
+  REAL big = 0.0;
+
+  if (P == 1)
+    return normalize_vec_COMPLEX(z, m);
+
+  for (i = 0; i < m; i++) {
+    COMPLEX t = cxzero;
+    for (p = 0; p < P; p++)
+      if ((i & p) & 1)
+	t = Csub(t, z[p * m + i]);
+      else
+	t = Cadd(t, z[p * m + i]);
+    big = max(big, Cabs(t));
+  }
+
+  if (big > 0.0) {
+    REAL scl = (REAL) (1.0 / big);
+    for (i = 0; i < P * m; i++)
+      z[i] = Cscl(z[i], scl);
+    return scl;
+  } else
+    return 0.0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Claim the spare response of an OvSv filter 
+* 
+* for redesign off the DSP thread. A response staged
+* but not yet picked up is taken back and overwritten.
+* Fill it with loadresp_OvSv, then publish_OvSv.
+*
+* @param pflt 
+* @return *COMPLEX
+*/
+/* ---------------------------------------------------------------------------- */
+COMPLEX *
+claim_OvSv(FiltOvSv pflt) {
+  while (!__sync_bool_compare_and_swap(&pflt->stage, OVSV_IDLE, OVSV_BUSY)
+	 && !__sync_bool_compare_and_swap(&pflt->stage, OVSV_READY, OVSV_BUSY))
+    sched_yield();
+  return pflt->zfnew;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Publish the spare response of an OvSv filter 
+* 
+* the filter swaps it in at the start of its next block,
+* crossfading over that block if asked
+*
+* @param pflt 
+* @param fade 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+publish_OvSv(FiltOvSv pflt, BOOLEAN fade) {
+  pflt->fade = fade;
+  __sync_synchronize();
+  pflt->stage = OVSV_READY;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Drop a staged response not yet picked up 
+* 
+* for when the response is set directly
+*
+* @param pflt 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+cancel_OvSv(FiltOvSv pflt) {
+  __sync_bool_compare_and_swap(&pflt->stage, OVSV_READY, OVSV_IDLE);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Size of the OvSv filter response 
+* 
+* all partitions, in COMPLEX
+*
+* @param pflt 
+* @return int
+*/
+/* ---------------------------------------------------------------------------- */
+int
+FiltOvSv_respsize(FiltOvSv pflt) {
+  return pflt->npart * pflt->fftlen;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Carry input history to another OvSv filter 
+* 
+* for changing buffer length on the fly:
+* the left half of zrvec holds the last input block,
+* hand over as much of it as the new filter has room for
+* so the first output block isn't a cold start
+*
+* @param to 
+* @param from 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+carry_OvSv(FiltOvSv to, FiltOvSv from) {
+  int m = to->buflen, n = from->buflen;
+  reset_OvSv(to);
+  if (m <= n)
+    memcpy((char *) to->zrvec,
+	   (char *) &from->zrvec[n - m],
+	   m * sizeof(COMPLEX));
+  else
+    memcpy((char *) &to->zrvec[m - n],
+	   (char *) from->zrvec,
+	   n * sizeof(COMPLEX));
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief Destroy a OvSv filter 
 * 
@@ -291,6 +649,9 @@ delFiltOvSv(FiltOvSv p) {
     delvec_COMPLEX_fftw(p->zivec);
     delvec_COMPLEX_fftw(p->zovec);
     delvec_COMPLEX_fftw(p->zrvec);
+    delvec_COMPLEX_fftw(p->zdvec);
+    delvec_COMPLEX_fftw(p->zfnew);
+    delvec_COMPLEX_fftw(p->zsvec);
     fftwf_destroy_plan(p->pfwd);
     fftwf_destroy_plan(p->pinv);
     safefree((char *) p);
@@ -44,14 +44,35 @@ Bridgewater, NJ 08807
 #include <lmadf.h>
 #include <fftw3.h>
 
+// who has the spare response
+#define OVSV_IDLE (0)	// nobody, free to claim
+#define OVSV_BUSY (1)	// designer filling it
+#define OVSV_READY (2)	// filled, goes in at the next block
+#define OVSV_SWAP (3)	// filter going in
+
 typedef struct _filt_ov_sav {
   int buflen, fftlen;
-  COMPLEX *zfvec, *zivec, *zovec, *zrvec;
+  int npart, fdl;	// partitions, head of freq-domain delay line
+  COMPLEX *zfvec, *zivec, *zovec, *zrvec, *zdvec;
+  COMPLEX *zfnew,	// spare response, filled off the DSP thread
+          *zsvec;	// scratch for the block where it goes in
+  int stage;
+  BOOLEAN fade;
   fftwf_plan pfwd, pinv;
   REAL scale;
 } filt_ov_sv, *FiltOvSv;
 
 extern FiltOvSv newFiltOvSv(COMPLEX *coefs, int ncoef, int pbits);
+extern FiltOvSv newFiltOvSvPart(COMPLEX *coefs, int ncoef, int buflen, int pbits);
+extern void load_OvSv(FiltOvSv pflt, COMPLEX *coefs, int ncoef, int pbits);
+extern REAL normalize_OvSv(FiltOvSv pflt);
+extern void loadresp_OvSv(FiltOvSv pflt, COMPLEX *z, COMPLEX *coefs, int ncoef, int pbits);
+extern REAL normresp_OvSv(FiltOvSv pflt, COMPLEX *z);
+extern COMPLEX *claim_OvSv(FiltOvSv pflt);
+extern void publish_OvSv(FiltOvSv pflt, BOOLEAN fade);
+extern void cancel_OvSv(FiltOvSv pflt);
+extern int FiltOvSv_respsize(FiltOvSv pflt);
+extern int FiltOvSv_npart(int ncoef, int buflen);
 extern void delFiltOvSv(FiltOvSv p);
 
 extern COMPLEX *FiltOvSv_initpoint(FiltOvSv pflt);
@@ -65,5 +86,6 @@ extern int FiltOvSv_storesize(FiltOvSv pflt);
 
 extern void filter_OvSv(FiltOvSv pflt);
 extern void reset_OvSv(FiltOvSv pflt);
+extern void carry_OvSv(FiltOvSv to, FiltOvSv from);
 
 #endif
@@ -110,11 +110,98 @@ send_command(dttsp_port_client_t *cp, char *cmdstr) {
   return 0;
 }
 
+// a quantized frame, after label and stamp (setSpectrumFormat):
+//   magic, format byte, flags byte, 16-bit sequence, 32-bit count,
+//   float offset, float scale; then 8- or 16-bit codes,
+//   each bin is offset + scale * code.
+// delta frames carry only the change in each code since the
+// frame before, run-length coded: a control byte c under 128
+// is followed by c + 1 changes, 128 and up means c - 126 bins
+// didn't change.
+
+static int
+unquantize(dttsp_port_client_t *cp, char *p, int len, float *data, int npts) {
+  unsigned short seq;
+  unsigned int count;
+  float off, scl;
+  int i, fmt = p[4], flags = p[5],
+      unit = fmt == DTTSP_PORT_CLIENT_SPEC_U8 ? 1 : 2,
+      top = unit == 1 ? 255 : 65535;
+  char *q = p + DTTSP_PORT_CLIENT_SPEC_HEAD, *end = p + len;
+
+  memcpy((char *) &seq, p + 6, 2);
+  memcpy((char *) &count, p + 8, 4);
+  memcpy((char *) &off, p + 12, 4);
+  memcpy((char *) &scl, p + 16, 4);
+
+  if (count > cp->spec.room) {
+    unsigned short *c = realloc(cp->spec.code, count * sizeof(unsigned short));
+    if (!c)
+      return -4;
+    cp->spec.code = c, cp->spec.room = count;
+  }
+
+  if (flags & DTTSP_PORT_CLIENT_SPEC_DELTA) {
+    // have to have had the one it's a change from
+    if (!cp->spec.ok || cp->spec.n != count
+	|| seq != (unsigned short) (cp->spec.seq + 1)) {
+      cp->spec.ok = 0;
+      return -3;
+    }
+    i = 0;
+    while (i < count && q < end) {
+      int c = (unsigned char) *q++;
+      if (c >= 128)
+	i += c - 126;
+      else
+	for (c++; c > 0 && i < count && q + unit <= end; c--, i++) {
+	  unsigned short d;
+	  if (unit == 1)
+	    d = (unsigned char) *q++;
+	  else
+	    memcpy((char *) &d, q, 2), q += 2;
+	  cp->spec.code[i] = (cp->spec.code[i] + d) & top;
+	}
+    }
+    if (i != count) {
+      cp->spec.ok = 0;
+      return -4;
+    }
+  } else {
+    if (end - q < count * unit)
+      return -4;
+    for (i = 0; i < count; i++)
+      if (unit == 1)
+	cp->spec.code[i] = (unsigned char) *q++;
+      else
+	memcpy((char *) &cp->spec.code[i], q, 2), q += 2;
+  }
+  cp->spec.n = count, cp->spec.seq = seq, cp->spec.ok = 1;
+
+  if (npts > count)
+    npts = count;
+  for (i = 0; i < npts; i++)
+    data[i] = off + scl * cp->spec.code[i];
+  return npts;
+}
+
+// fetch a spectrum frame, float or quantized
+// success return: how many points came, at most npts;
+//   fewer than asked for if the server is binning (setSpectrumBins)
+// error returns:
+// -1: nothing showed up in time
+// -2: failed to receive it
+// -3: a delta frame, but not from the last one we got;
+//     good again at the next whole frame
+// -4: garbled quantized frame
+
 int
 fetch_spectrum(dttsp_port_client_t *cp,
 	       int *tick, int *label, float *data, int npts) {
   fd_set fds;
   struct timeval tv;
+  int len;
+  unsigned int magic = 0;
 
   // wait a bit for data to appear
   FD_ZERO(&fds);
@@ -123,15 +210,27 @@ fetch_spectrum(dttsp_port_client_t *cp,
   tv.tv_usec = 0;
   if (!select(cp->sock + 1, &fds, 0, 0, &tv))
     return -1;
-  if (recvfrom(cp->sock, cp->buff, cp->size, cp->flags,
-	       (struct sockaddr *) &cp->clnt, &cp->clen) <= 0)
+  if ((len = recvfrom(cp->sock, cp->buff, cp->size, cp->flags,
+		      (struct sockaddr *) &cp->clnt, &cp->clen)) <= 0)
     return -2;
 
-  // copy payload back to client space
   memcpy((char *) tick, cp->buff, sizeof(int));
   memcpy((char *) label, cp->buff + sizeof(int), sizeof(int));
-  memcpy((char *) data, cp->buff + 2 * sizeof(int), npts * sizeof(float));
-  return 0;
+  len -= 2 * (int) sizeof(int);
+
+  if (len >= DTTSP_PORT_CLIENT_SPEC_HEAD)
+    memcpy((char *) &magic, cp->buff + 2 * sizeof(int), sizeof(magic));
+  if (magic == DTTSP_PORT_CLIENT_SPEC_MAGIC)
+    return unquantize(cp, cp->buff + 2 * sizeof(int), len, data, npts);
+
+  // copy payload back to client space
+  len /= (int) sizeof(float);
+  if (len < 0)
+    len = 0;
+  if (len > npts)
+    len = npts;
+  memcpy((char *) data, cp->buff + 2 * sizeof(int), len * sizeof(float));
+  return len;
 }
 
 int
@@ -193,6 +292,10 @@ new_dttsp_port_client(int port, int inbound) {
   cp->size = DTTSP_PORT_CLIENT_BUFSIZE;
   memset(cp->buff, 0, cp->size);
 
+  cp->spec.code = 0;
+  cp->spec.room = cp->spec.n = cp->spec.ok = 0;
+  cp->spec.seq = 0;
+
   return cp;
 }
 
@@ -200,6 +303,7 @@ void
 del_dttsp_port_client(dttsp_port_client_t *cp) {
   if (cp) {
     close(cp->sock);
+    free(cp->spec.code);
     free(cp);
   }
 }
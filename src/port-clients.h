@@ -59,12 +59,23 @@ Bridgewater, NJ 08807
 #define DTTSP_PORT_CLIENT_METER 19003
 #define DTTSP_PORT_CLIENT_BUFSIZE 65536
 
+// quantized spectrum frames; same as SPEC_WIRE_* in spectrum.h
+#define DTTSP_PORT_CLIENT_SPEC_U8 1
+#define DTTSP_PORT_CLIENT_SPEC_U16 2
+#define DTTSP_PORT_CLIENT_SPEC_MAGIC 0x51505344
+#define DTTSP_PORT_CLIENT_SPEC_DELTA 1
+#define DTTSP_PORT_CLIENT_SPEC_HEAD 20
+
 typedef struct _dttsp_port_client {
   unsigned short port;
   struct sockaddr_in clnt;
   int clen, flags, sock;
   char buff[DTTSP_PORT_CLIENT_BUFSIZE];
   int size, used;
+  struct {
+    unsigned short *code, seq;
+    int room, n, ok;
+  } spec;	// last quantized frame, for the delta ones after it
 } dttsp_port_client_t;
 
 extern int send_command(dttsp_port_client_t *cp, char *cmdstr);
@@ -38,15 +38,53 @@ Bridgewater, NJ 08807
 #include <resample.h>
 
 /* -------------------------------------------------------------------------- */
-/** @brief New Polyphase FIR filter
+/** @brief private dot product of a history window with one phase's taps
 * 
+* @param x ntap samples
+* @param h ntap taps, each twice over
+* @param ntap multiple of 4
+* @return COMPLEX
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE INLINE COMPLEX
+dotbank(COMPLEX *x, REAL *h, int ntap) {
+  COMPLEX z;
+  int i;
+
+#ifdef __SSE3__
+  __m128 s0 = _mm_setzero_ps(),
+         s1 = _mm_setzero_ps();
+
+  for (i = 0; i < 2 * ntap; i += 8) {
+    s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps((float *) x + i),
+				   _mm_load_ps(h + i)));
+    s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps((float *) x + i + 4),
+				   _mm_load_ps(h + i + 4)));
+  }
+  s0 = _mm_add_ps(s0, s1);
+  s0 = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+  _mm_storel_pi((__m64 *) &z, s0);
+#else
+  z = cxzero;
+  for (i = 0; i < ntap; i++)
+    z = Cadd(z, Cscl(x[i], h[2 * i]));
+#endif
+
+  return z;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief New Polyphase FIR resampler
+* 
+* out rate = in rate * intrp / decim, any ratio;
+* it's reduced to lowest terms first
+*
 * @param source 
-* @param insize 
+* @param insize most input samples per call
 * @param dest 
-* @param iold 
 * @param intrp 
-* @param phase 
 * @param decim 
+* @param nflt prototype lowpass length, 0 for 31 * max(intrp, decim)
 * @return ResSt
 */
 /* ---------------------------------------------------------------------------- */
@@ -54,24 +92,42 @@ ResSt
 newPolyPhaseFIR(CXB source,
 		int insize,
 		CXB dest,
-		int iold,
 		int intrp,
-		int phase,
-		int decim) {
+		int decim,
+		int nflt) {
   ResSt r = (ResSt) safealloc(1, sizeof(resampler), "PF Resampler");
+  int g = gcd(intrp, decim), most, p, j;
+
+  intrp /= g, decim /= g;
+  most = max(intrp, decim);
+  if (nflt <= 0)
+    nflt = 31 * most;
 
-  r->iold  = iold;
   r->intrp = intrp;
-  r->phase = phase;
   r->decim = decim;
-  r->nflt  = 31 * decim;
-  r->nold  = nblock2(r->nflt);
-  r->mask  = r->nold - 1;
+  r->phase = 0;
+  // lowpass runs at intrp times the input rate,
+  // cut off short of the lower of the input and output Nyquist
+  r->filt  = newFIR_Lowpass_REAL(0.45f * (REAL) intrp / (REAL) most,
+				 (REAL) intrp,
+				 nflt);
+  r->nflt  = FIRsize(r->filt);
+
+  // phase p takes taps p, p + intrp, p + 2 intrp, ...
+  // laid out backwards so they run forward over the history,
+  // padded with zeros to a whole number of SIMD steps
+  r->ntap  = (((r->nflt + intrp - 1) / intrp) + 3) & ~3;
+  r->bank  = newvec_REAL(2 * r->ntap * intrp, "resampler taps");
+  for (p = 0; p < intrp; p++)
+    for (j = 0; p + j * intrp < r->nflt; j++) {
+      REAL *h = r->bank + 2 * (p * r->ntap + r->ntap - 1 - j);
+      h[0] = h[1] = FIRtap(r->filt, p + j * intrp) * (REAL) intrp;
+    }
+
   r->inp   = CXBbase(source);
   r->nnew  = insize;
   r->out   = CXBbase(dest);
-  r->old   = (COMPLEX *) safealloc(r->nold, sizeof(COMPLEX), "resampler past");
-  r->filt  = newFIR_Lowpass_REAL(0.45f / (REAL) decim, (REAL) intrp, r->nflt);
+  r->hist  = newvec_COMPLEX(PolyPhaseFIR_histsize(r, insize), "resampler past");
 
   return r;
 }
@@ -87,12 +143,51 @@ void
 delPolyPhaseFIR(ResSt r) {
   if (r)
     delFIR_Lowpass_REAL(r->filt),
-    safefree((char *) r->old),
+    delvec_REAL(r->bank),
+    delvec_COMPLEX(r->hist),
     safefree((char *) r);
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief History length for a given input size
+* 
+* @param r 
+* @param insize 
+* @return int
+*/
+/* ---------------------------------------------------------------------------- */
+int
+PolyPhaseFIR_histsize(ResSt r, int insize) {
+  return r->ntap - 1 + insize;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Move a running resampler onto a new input size
+*
+* hist comes from PolyPhaseFIR_histsize(r, insize), built ahead of time;
+* the past carries over. Returns the old history for freeing.
+* 
+* @param r 
+* @param hist 
+* @param insize 
+* @return COMPLEX *
+*/
+/* ---------------------------------------------------------------------------- */
+COMPLEX *
+resizePolyPhaseFIR(ResSt r, COMPLEX *hist, int insize) {
+  COMPLEX *old = r->hist;
+
+  memcpy((char *) hist, (char *) old, (r->ntap - 1) * sizeof(COMPLEX));
+  r->hist = hist;
+  r->nnew = insize;
+  return old;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief PolyPhase FIR filter 
+*
+* input is copied into the history first,
+* so inp and out may be the same buffer
 * 
 * @param r 
 * @return void
@@ -100,63 +195,57 @@ delPolyPhaseFIR(ResSt r) {
 /* ---------------------------------------------------------------------------- */
 void
 PolyPhaseFIR(ResSt r) {
-  int i, n = 0;
-
-  for (i = 0; i < r->nnew; i++) {
-
-    r->old[r->iold] = r->inp[i];
-
-    while (r->phase < r->intrp) {
-      COMPLEX sum = cxzero;
-      int j = r->iold, k;
-
-      for (k = r->phase; k < r->nflt; k += r->intrp) {
-	sum = Cadd(sum, Cscl(r->old[j], FIRtap(r->filt, k)));
-	j = (j + r->mask) & r->mask;
-      }
-
-      r->out[n] = Cscl(sum, (REAL) r->intrp);
-      r->phase += r->decim;
-      n++;
-    }
-
-    r->iold = (r->iold + 1) & r->mask;
-    r->phase -= r->intrp;
+  int n, g = r->phase,
+      lim = r->nnew * r->intrp,
+      past = r->ntap - 1;
+
+  memcpy((char *) (r->hist + past),
+	 (char *) r->inp,
+	 r->nnew * sizeof(COMPLEX));
+
+  // output n sits at g = phase + n * decim on the upsampled grid:
+  // newest input g / intrp, filter phase g % intrp
+  for (n = 0; g < lim; n++, g += r->decim) {
+    int i = g / r->intrp;
+    r->out[n] = dotbank(r->hist + i,
+			r->bank + 2 * (g - i * r->intrp) * r->ntap,
+			r->ntap);
   }
 
+  r->phase = g - lim;
   r->nout = n;
+
+  memmove((char *) r->hist,
+	  (char *) (r->hist + r->nnew),
+	  past * sizeof(COMPLEX));
 }
 
 /** 
 * *inp              pointer to inp COMPLEX data array
 * *out              pointer to out COMPLEX data array
-* filt              pointer to filt coefficients array
-* *old              pointer to buffer used as filt memory. Initialized
-*                   all data to 0 before 1st call.  length is calculated
-*                   from nflt
-* nold              length of old
+* filt              prototype lowpass, at intrp times the input rate
+* bank              filt split into intrp phases of ntap taps each,
+*                   time-reversed and scaled by intrp
+* *hist             the last ntap-1 inputs, then room for nnew more;
+*                   each output is one contiguous dot product over it
 * nnew              length of inp array :note that "out" may differ in length
-* nflt              number of filt taps in array "filtcoeff": < nold
-* iold              index to where next inp sample is to be stored in
-*                   "old",initalized 0 to before first call
+* nflt              number of taps in filt
 * intrp             interpolation factor: out rate = inp rate * interp / decim.
-* phase             filt phase number (index), initialized to 0
+* phase             position of the next output on the upsampled grid,
+*                   relative to the next input; initialized to 0
 * decim             decimation factor:
 *                   out rate = (inp rate * interp/decim)
-* nout              number of out samples placed in array "out"
+* nout              number of out samples placed in array "out",
+*                   at most ceil(nnew * intrp / decim)
 *
 * DESCRIPTION: This function is used to change the sampling rate of the data.
 *              The inp is first upsampled to a multiple of the desired
 *              sampling rate and then down sampled to the desired sampling rate.
+*              Only the filter phases that land on an output get computed.
 *
 *              Ex. If we desire a 7200 Hz sampling rate for a signal that has
 *                  been sampled at 8000 Hz the signal can first be upsampled
 *                  by a factor of 9 which brings it up to 72000 Hz and then
 *                  down sampled by a factor of 10 which results in a sampling
 *                  rate of 7200 Hz.
-*
-* NOTES:
-*        Also, the "*old" MUST be 2^N REALs long. This
-*        routine uses circular addressing on this buffer assuming that
-*        it is 2^N REALs in length.
 */
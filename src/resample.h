@@ -44,26 +44,27 @@ Bridgewater, NJ 08807
 
 typedef
 struct resample_state {
-  COMPLEX *inp, *out, *old;
+  COMPLEX *inp, *out,
+          *hist;	// ntap-1 past inputs, then the current block
+  REAL *bank;		// per-phase taps, time-reversed, each one doubled
   RealFIR filt;
-  int nold,
-      nnew,
+  int nnew,
       nout,
       nflt,
-      iold,
+      ntap,		// taps per phase, a multiple of 4
       intrp,
       phase,
-      decim,
-      mask;
+      decim;
 } resampler, *ResSt;
 
 extern ResSt newPolyPhaseFIR(CXB source,
 			     int insize,
 			     CXB dest,
-			     int iold,
 			     int intrp,
-			     int phsf,
-			     int decim);
+			     int decim,
+			     int nflt);
 extern void PolyPhaseFIR(ResSt r);
+extern int PolyPhaseFIR_histsize(ResSt r, int insize);
+extern COMPLEX *resizePolyPhaseFIR(ResSt r, COMPLEX *hist, int insize);
 extern void delPolyPhaseFIR(ResSt r);
 #endif
@@ -174,6 +174,10 @@ ringb_float_clear(ringb_float_t *rb, size_t nfloats) {
 /* -------------------------------------------------------------------------- */
 /** @brief Restart the ring buffer 
 * 
+* empty but for nbytes of silence, laid down just ahead of
+* the start so that whatever gets written next begins there,
+* and blocks written a power of 2 at a time never wrap
+*
 * @param rb 
 * @param nbytes 
 * @return void
@@ -181,13 +185,16 @@ ringb_float_clear(ringb_float_t *rb, size_t nfloats) {
 /* ---------------------------------------------------------------------------- */
 void
 ringb_restart(ringb_t *rb, size_t nbytes) {
-  ringb_reset(rb);
+  // NB not thread-safe
+  rb->rptr = rb->wptr = (rb->size - nbytes) & rb->mask;
   ringb_clear(rb, nbytes);
 }
 
 /* -------------------------------------------------------------------------- */
 /** @brief Restart the float ring buffer 
 * 
+* as ringb_restart
+*
 * @param rb 
 * @param nfloats 
 * @return void
@@ -195,7 +202,8 @@ ringb_restart(ringb_t *rb, size_t nbytes) {
 /* ---------------------------------------------------------------------------- */
 void
 ringb_float_restart(ringb_float_t *rb, size_t nfloats) {
-  ringb_float_reset(rb);
+  // NB not thread-safe
+  rb->rptr = rb->wptr = (rb->size - nfloats) & rb->mask;
   ringb_float_clear(rb, nfloats);
 }
 
@@ -420,6 +428,19 @@ ringb_read_advance(ringb_t *rb, size_t cnt) {
   rb->rptr = (rb->rptr + cnt) & rb->mask;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief Read advanced float ring buffer 
+* 
+* @param rb 
+* @param cnt 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+ringb_float_read_advance(ringb_float_t *rb, size_t cnt) {
+  rb->rptr = (rb->rptr + cnt) & rb->mask;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief Write advanced ring buffer 
 * 
@@ -433,6 +454,19 @@ ringb_write_advance(ringb_t *rb, size_t cnt) {
   rb->wptr = (rb->wptr + cnt) & rb->mask;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief Write advanced float ring buffer 
+* 
+* @param rb 
+* @param cnt 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+ringb_float_write_advance(ringb_float_t *rb, size_t cnt) {
+  rb->wptr = (rb->wptr + cnt) & rb->mask;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief Get the read vector of from the ring buffer
 * 
@@ -457,6 +491,30 @@ ringb_get_read_vector(const ringb_t *rb, ringb_data_t *vec) {
   }
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief Get the read vector of from the float ring buffer
+* 
+* @param rb 
+* @param vec 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+ringb_float_get_read_vector(const ringb_float_t *rb, ringb_floatdata_t *vec) {
+  size_t free_cnt, cnt2, w = rb->wptr, r = rb->rptr;
+  if (w > r)
+    free_cnt = w - r;
+  else
+    free_cnt = (w - r + rb->size) & rb->mask;
+  if ((cnt2 = r + free_cnt) > rb->size) {
+    vec[0].buf = &(rb->buf[r]), vec[0].len = rb->size - r;
+    vec[1].buf = rb->buf, vec[1].len = cnt2 & rb->mask;
+  } else {
+    vec[0].buf = &(rb->buf[r]), vec[0].len = free_cnt;
+    vec[1].len = 0;
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief Get the write vector ring buffer 
 * 
@@ -482,3 +540,29 @@ ringb_get_write_vector(const ringb_t *rb, ringb_data_t *vec) {
     vec[1].len = 0;
   }
 }
+
+/* -------------------------------------------------------------------------- */
+/** @brief Get the write vector float ring buffer 
+* 
+* @param rb 
+* @param vec 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+ringb_float_get_write_vector(const ringb_float_t *rb, ringb_floatdata_t *vec) {
+  size_t free_cnt, cnt2, w = rb->wptr, r = rb->rptr;
+  if (w > r)
+    free_cnt = ((r - w + rb->size) & rb->mask) - 1;
+  else if (w < r)
+    free_cnt = r - w - 1;
+  else
+    free_cnt = rb->size - 1;
+  if ((cnt2 = w + free_cnt) > rb->size) {
+    vec[0].buf = &(rb->buf[w]), vec[0].len = rb->size - w;
+    vec[1].buf = rb->buf, vec[1].len = cnt2 & rb->mask;
+  } else {
+    vec[0].buf = &(rb->buf[w]), vec[0].len = free_cnt;
+    vec[1].len = 0;
+  }
+}
@@ -88,6 +88,8 @@ extern void ringb_float_free(ringb_float_t *rb);
  *vec a pointer to a 2 element array of ringb_data_t. */
 
 extern void ringb_get_read_vector(const ringb_t *rb, ringb_data_t *vec);
+extern void ringb_float_get_read_vector(const ringb_float_t *rb,
+					ringb_floatdata_t *vec);
 
 /* Fill a data structure with a description of the current writable
  * space in the ringbuffer.  The description is returned in a two
@@ -105,6 +107,8 @@ extern void ringb_get_read_vector(const ringb_t *rb, ringb_data_t *vec);
  *vec a pointer to a 2 element array of ringb_data_t. */
 
 extern void ringb_get_write_vector(const ringb_t *rb, ringb_data_t *vec);
+extern void ringb_float_get_write_vector(const ringb_float_t *rb,
+					 ringb_floatdata_t *vec);
 
 /*
  * Read data from the ringbuffer.
@@ -141,6 +145,7 @@ extern size_t ringb_peek(ringb_t *rb, char *dest, size_t cnt);
  * cnt the number of bytes read. */
 
 extern void ringb_read_advance(ringb_t *rb, size_t cnt);
+extern void ringb_float_read_advance(ringb_float_t *rb, size_t cnt);
 
 /* Return the number of bytes available for reading.
  *rb a pointer to the ringbuffer structure.
@@ -174,6 +179,7 @@ extern size_t ringb_float_write(ringb_float_t *rb, const float *src,
  * cnt the number of bytes written. */
 
 extern void ringb_write_advance(ringb_t *rb, size_t cnt);
+extern void ringb_float_write_advance(ringb_float_t *rb, size_t cnt);
 
 /* Return the number of bytes(floats) available for writing.
  *rb a pointer to the ringbuffer structure.
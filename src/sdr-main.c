@@ -50,7 +50,8 @@ struct _loc loc;
 extern void reset_meters(void);
 extern void reset_spectrum(void);
 extern void reset_counters(void);
-extern void process_samples(float *, float *, int);
+extern void process_samples(float *, float *, float *, float *, int);
+extern int chain_delay(void);
 extern void setup_workspace(REAL samplerate,
 			    int buflen,
 			    SDRMODE mode,
@@ -60,12 +61,22 @@ extern void setup_workspace(REAL samplerate,
 			    int cpdsize);
 extern void destroy_workspace(void);
 extern int reset_for_buflen(int new_buflen);
+extern void settle_resize(void);
+extern void build_for_buflen(int len);
+extern void swap_for_buflen(void);
+extern void free_for_buflen(void);
+extern void run_designs(void);
+extern void rx_worker_thread(void *arg);
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
 /* @brief private spectrum_thread 
+ *
+ * serves every tap that's on, each to its own port;
+ * builds and frees taps when asked, see tend_spectrum
+ *
  * @return void
  */
 
@@ -83,55 +94,81 @@ spectrum_thread(void) {
   clnt_len = sizeof(clnt);
   memset((char *) &clnt, 0, clnt_len);
   clnt.sin_family = AF_INET;
-  clnt.sin_addr.s_addr = htonl(INADDR_ANY);
-  clnt.sin_port = htons(port);
 
   if (top->verbose)
     fprintf(stderr, "%s: Ready to return spectrum on port %d\n", top->snds.name, port);
 
   while (top->running) {
-    int sp_blen;
-    char sp_buff[32768];
+    int k;
 
     sem_wait(top->sync.pws.sem);
-    sem_wait(top->sync.upd.sem);
 
-    // generate & pack up data to be sent
+    for (k = 0; k < MAXSPEC; k++) {
+      SpecBlock *sb = &uni->spec[k];
+      int sp_blen, state = tap_spectrum(sb);
+      char sp_buff[65536];
+      SpecSnap *ss;
+
+      if (state == SPEC_TAP_OFF)
+	continue;
+      if (state != SPEC_TAP_ON) {
+	// plans get made and destroyed; keep out of the way
+	// of the other planners, like the design thread does
+	sem_wait(top->sync.upd.sem);
+	state = tend_spectrum(sb);
+	sem_post(top->sync.upd.sem);
+	if (state != SPEC_TAP_ON)
+	  continue;
+      }
 
-    {
-      char *ptr = sp_buff;
-      memcpy(ptr, (char *) &uni->spec.label, sizeof(int));
-      ptr += sizeof(int);
-      memcpy(ptr, (char *) &uni->spec.stamp, sizeof(int));
-      ptr += sizeof(int);
+      // no lock; works from a snapshot the DSP thread let go of
+      if (!(ss = claim_spectrum(sb)))
+	continue;
+
+      // generate & pack up data to be sent
+
+      {
+	char *ptr = sp_buff;
+	memcpy(ptr, (char *) &ss->label, sizeof(int));
+	ptr += sizeof(int);
+	memcpy(ptr, (char *) &ss->stamp, sizeof(int));
+	ptr += sizeof(int);
+
+	// spectrum or scope?
+
+	if (ss->last == SPEC_LAST_FREQ) {
+	  int n = compute_spectrum(sb, ss);
+	  if (ss->view.wire == SPEC_WIRE_FLOAT) {
+	    int cnt = sizeof(float) * n;
+	    memcpy(ptr, (char *) sb->output, cnt);
+	    ptr += cnt;
+	  } else
+	    ptr += encode_spectrum(sb, &ss->view, n, ptr);
+	} else {
+	  int cnt = sizeof(float) * sb->size;
+	  compute_scope(sb, ss);
+	  memcpy(ptr, (char *) sb->oscope, cnt);
+	  ptr += cnt;
+	}
+	sp_blen = ptr - sp_buff;
+      }
 
-      // spectrum or scope?
+      release_spectrum(sb, ss);
 
-      if (uni->spec.last == SPEC_LAST_FREQ) {
-	int cnt = sizeof(float) * uni->spec.size;
-	compute_spectrum(&uni->spec);
-	memcpy(ptr, (char *) uni->spec.output, cnt);
-	ptr += cnt;
-      } else {
-	int cnt = sizeof(float) * uni->spec.size;
-	memcpy(ptr, (char *) uni->spec.oscope, cnt);
-	ptr += cnt;
-      }
-      sp_blen = ptr - sp_buff;
-    }
+      clnt.sin_addr.s_addr = sb->dest.addr ? sb->dest.addr : htonl(INADDR_ANY);
+      clnt.sin_port = htons(sb->dest.port ? sb->dest.port : port + k);
 
-    if (sendto(sock,
-	       sp_buff,
-	       sp_blen,
-	       0,
-	       (struct sockaddr *) &clnt,
-	       clnt_len)
-	!= sp_blen) {
-      perror("Failed to send spectrum");
-      exit(1);
+      if (sendto(sock,
+		 sp_buff,
+		 sp_blen,
+		 0,
+		 (struct sockaddr *) &clnt,
+		 clnt_len)
+	  != sp_blen) {
+	perror("Failed to send spectrum");
+	exit(1);
+      }
     }
-
-    sem_post(top->sync.upd.sem);
   }
 
   close(sock);
@@ -212,6 +249,28 @@ meter_thread(void) {
 
 //////////////////////////////////////////////////////////////////////////
 
+/* @brief private design_thread
+ *
+ * filter redesigns asked for by commands, off the DSP thread;
+ * holds upd while at it, like any other command source
+ *
+ * @return void
+ */
+
+PRIVATE void
+design_thread(void) {
+  while (top->running) {
+    sem_wait(top->sync.dsg.sem);
+    sem_wait(top->sync.upd.sem);
+    settle_resize();
+    run_designs();
+    sem_post(top->sync.upd.sem);
+  }
+  pthread_exit(0);
+}
+
+//////////////////////////////////////////////////////////////////////////
+
 /* @brief private process_updates_thread 
  * @return void
  */
@@ -328,13 +387,19 @@ process_updates_thread(void) {
 
 PRIVATE void
 run_mute(void) {
-  memset((char *) top->hold.buf.l, 0, top->hold.size.bytes);
-  memset((char *) top->hold.buf.r, 0, top->hold.size.bytes);
+  memset((char *) top->hold.out.l, 0, top->hold.size.bytes);
+  memset((char *) top->hold.out.r, 0, top->hold.size.bytes);
   uni->tick++;
 }
 
 PRIVATE void
-run_pass(void) { uni->tick++; }
+run_pass(void) {
+  if (top->hold.out.l != top->hold.in.l) {
+    memcpy((char *) top->hold.out.l, (char *) top->hold.in.l, top->hold.size.bytes);
+    memcpy((char *) top->hold.out.r, (char *) top->hold.in.r, top->hold.size.bytes);
+  }
+  uni->tick++;
+}
 
 PRIVATE void
 run_play(void) {
@@ -343,20 +408,22 @@ run_play(void) {
     int i;
     float sum = 0.0;
     for (i = 0; i < top->hold.size.frames; i++)
-      sum += sqr(top->hold.buf.l[i]) + sqr(top->hold.buf.r[i]);
+      sum += sqr(top->hold.in.l[i]) + sqr(top->hold.in.r[i]);
     fprintf(stdout, "%9d %9.6f",
 	    uni->tick, sqrt(sum / top->hold.size.frames));
   }
 #endif
 
-  process_samples(top->hold.buf.l, top->hold.buf.r, top->hold.size.frames);
+  process_samples(top->hold.in.l, top->hold.in.r,
+		  top->hold.out.l, top->hold.out.r,
+		  top->hold.size.frames);
 
 #if 0
   {
     int i;
     float sum = 0.0;
     for (i = 0; i < top->hold.size.frames; i++)
-      sum += sqr(top->hold.buf.l[i]) + sqr(top->hold.buf.r[i]);
+      sum += sqr(top->hold.out.l[i]) + sqr(top->hold.out.r[i]);
     fprintf(stdout, " %9.6f\n", sqrt(sum / top->hold.size.frames));
   }
   fflush(stdout);
@@ -372,14 +439,16 @@ run_swch(void) {
   int i, n = top->hold.size.frames;
   REAL w;
 
-  process_samples(top->hold.buf.l, top->hold.buf.r, top->hold.size.frames);
+  process_samples(top->hold.in.l, top->hold.in.r,
+		  top->hold.out.l, top->hold.out.r,
+		  top->hold.size.frames);
 
   for (i = 0; i < n; i++) {
 
     if (top->swch.env.curr.type == SWCH_FALL) {
       top->swch.env.curr.val += top->swch.env.fall.incr;
       w = sin(top->swch.env.curr.val * M_PI /  2.0);
-      top->hold.buf.l[i] *= w, top->hold.buf.r[i] *= w;
+      top->hold.out.l[i] *= w, top->hold.out.r[i] *= w;
 
       if (++top->swch.env.curr.cnt >= top->swch.env.fall.size) {
 	top->swch.env.curr.type = SWCH_STDY;
@@ -388,7 +457,7 @@ run_swch(void) {
       }
 
     } else if (top->swch.env.curr.type == SWCH_STDY) {
-      top->hold.buf.l[i]= top->hold.buf.r[i] = 0.0;
+      top->hold.out.l[i]= top->hold.out.r[i] = 0.0;
 
       if (++top->swch.env.curr.cnt >= top->swch.env.stdy.size) {
 	top->swch.env.curr.type = SWCH_RISE;
@@ -399,7 +468,7 @@ run_swch(void) {
     } else if (top->swch.env.curr.type == SWCH_RISE) {
       top->swch.env.curr.val += top->swch.env.rise.incr;
       w = sin(top->swch.env.curr.val * M_PI /  2.0);
-      top->hold.buf.l[i] *= w, top->hold.buf.r[i] *= w;
+      top->hold.out.l[i] *= w, top->hold.out.r[i] *= w;
 
       if (++top->swch.env.curr.cnt >= top->swch.env.rise.size) {
 	uni->mode.trx = top->swch.trx.next;
@@ -419,18 +488,18 @@ run_test(void) {
   case TEST_TONE:
     ComplexOSC(top->test.tone.gen); // 1000
     for (i = 0; i < top->hold.size.frames; i++)
-      top->hold.buf.l[i] = OSCreal(top->test.tone.gen, i) * top->test.tone.amp,
-      top->hold.buf.r[i] = OSCimag(top->test.tone.gen, i) * top->test.tone.amp;
+      top->hold.out.l[i] = OSCreal(top->test.tone.gen, i) * top->test.tone.amp,
+      top->hold.out.r[i] = OSCimag(top->test.tone.gen, i) * top->test.tone.amp;
     break;
 
   case TEST_2TONE:
     ComplexOSC(top->test.twotone.a.gen); // 700
     ComplexOSC(top->test.twotone.b.gen); // 1900
     for (i = 0; i < top->hold.size.frames; i++)
-      top->hold.buf.l[i] =
+      top->hold.out.l[i] =
 	OSCreal(top->test.twotone.a.gen, i) * top->test.twotone.a.amp +
 	OSCreal(top->test.twotone.b.gen, i) * top->test.twotone.b.amp,
-      top->hold.buf.r[i] =
+      top->hold.out.r[i] =
 	OSCimag(top->test.twotone.a.gen, i) * top->test.twotone.a.amp +
 	OSCimag(top->test.twotone.b.gen, i) * top->test.twotone.b.amp;
     break;
@@ -438,14 +507,14 @@ run_test(void) {
 #define ransig(x) ((drand48() * 0.5 - 1.0) * (x))
   case TEST_NOISE:
     for (i = 0; i < top->hold.size.frames; i++)
-      top->hold.buf.l[i] = ransig(top->test.noise.amp),
-      top->hold.buf.r[i] = ransig(top->test.noise.amp);
+      top->hold.out.l[i] = ransig(top->test.noise.amp),
+      top->hold.out.r[i] = ransig(top->test.noise.amp);
     break;
 #undef ransig
 
   default:
-    memset((char *) top->hold.buf.l, 0, top->hold.size.bytes);
-    memset((char *) top->hold.buf.r, 0, top->hold.size.bytes);
+    memset((char *) top->hold.out.l, 0, top->hold.size.bytes);
+    memset((char *) top->hold.out.r, 0, top->hold.size.bytes);
     break;
   }
 
@@ -454,21 +523,23 @@ run_test(void) {
     int i;
     float sum = 0.0;
     for (i = 0; i < top->hold.size.frames; i++)
-      sum += sqr(top->hold.buf.l[i]) + sqr(top->hold.buf.r[i]);
+      sum += sqr(top->hold.out.l[i]) + sqr(top->hold.out.r[i]);
     fprintf(stdout, "%9d %9.6f",
 	    uni->tick, sqrt(sum / top->hold.size.frames));
   }
 #endif
 
   if (!top->test.thru)
-    process_samples(top->hold.buf.l, top->hold.buf.r, top->hold.size.frames);
+    process_samples(top->hold.out.l, top->hold.out.r,
+		    top->hold.out.l, top->hold.out.r,
+		    top->hold.size.frames);
 
 #if 0
   {
     int i;
     float sum = 0.0;
     for (i = 0; i < top->hold.size.frames; i++)
-      sum += sqr(top->hold.buf.l[i]) + sqr(top->hold.buf.r[i]);
+      sum += sqr(top->hold.out.l[i]) + sqr(top->hold.out.r[i]);
     fprintf(stdout, " %9.6f\n", sqrt(sum / top->hold.size.frames));
   }
   fflush(stdout);
@@ -514,6 +585,12 @@ audio_callback(jack_nframes_t nframes, void *arg) {
   lp = (float *) jack_port_get_buffer(top->snds.port.o.l, nframes);
   rp = (float *) jack_port_get_buffer(top->snds.port.o.r, nframes);
   
+  {
+    size_t have = ringb_float_read_space(top->snds.ring.o.l);
+    if (have > top->snds.stat.hwm.o)
+      top->snds.stat.hwm.o = have;
+  }
+
   if ((ringb_float_read_space(top->snds.ring.o.l) >= nframes) &&
       (ringb_float_read_space(top->snds.ring.o.r) >= nframes)) {
     ringb_float_read(top->snds.ring.o.l, lp, nframes);
@@ -521,17 +598,23 @@ audio_callback(jack_nframes_t nframes, void *arg) {
   } else {
     memset((char *) lp, 0, nbytes);
     memset((char *) rp, 0, nbytes);
+    top->snds.stat.unfl++;
   }
   
   // input: copy from port to ring
   if ((ringb_float_write_space(top->snds.ring.i.l) >= nframes) &&
       (ringb_float_write_space(top->snds.ring.i.l) >= nframes)) {
+    size_t have;
     lp = (float *) jack_port_get_buffer(top->snds.port.i.l, nframes);
     rp = (float *) jack_port_get_buffer(top->snds.port.i.r, nframes);
     ringb_float_write(top->snds.ring.i.l, lp, nframes);
     ringb_float_write(top->snds.ring.i.r, rp, nframes);
-  } else
+    if ((have = ringb_float_read_space(top->snds.ring.i.l)) > top->snds.stat.hwm.i)
+      top->snds.stat.hwm.i = have;
+  } else {
     top->snds.doin = TRUE;
+    top->snds.stat.ovfl++;
+  }
   
   // fire dsp
   sem_post(top->sync.buf.sem);
@@ -542,15 +625,233 @@ audio_callback(jack_nframes_t nframes, void *arg) {
  * @return void
  */
 
+PRIVATE void
+gather(float *dst, ringb_floatdata_t *vec, int n) {
+  int m = min(vec[0].len, n);
+  memcpy((char *) dst, (char *) vec[0].buf, m * sizeof(float));
+  if (m < n)
+    memcpy((char *) (dst + m), (char *) vec[1].buf, (n - m) * sizeof(float));
+}
+
+//------------------------------------------------------------------------
+// rate conversion between jack and dsp, done here on the DSP thread
+// as blocks come off and go onto the rings
+
+// length of the lowpass behind the converters, per filter phase
+#define CVT_TAPS (64)
+
+/* @brief private jack_frames
+ *
+ * most frames at the jack rate that make up n at ours
+ *
+ * @return int
+ */
+
+PRIVATE int
+jack_frames(int n) {
+  if (!top->snds.cvt.on)
+    return n;
+  return (int) ((long long) n * top->snds.cvt.rate / (int) uni->rate.sample) + 2;
+}
+
+/* @brief private fifo_frames
+ * @return int
+ */
+
+PRIVATE int
+fifo_frames(int n) {
+  return n + (int) uni->rate.sample / top->snds.cvt.rate + 2;
+}
+
+/* @brief private weave
+ *
+ * one channel off the ring into every other float,
+ * i.e. the real or imaginary halves of a complex buffer
+ *
+ * @return void
+ */
+
+PRIVATE void
+weave(float *dst, ringb_floatdata_t *vec, int n) {
+  int i, m = min(vec[0].len, n);
+  for (i = 0; i < m; i++)
+    dst[2 * i] = vec[0].buf[i];
+  for (; i < n; i++)
+    dst[2 * i] = vec[1].buf[i - m];
+}
+
+/* @brief private unweave
+ * @return void
+ */
+
+PRIVATE void
+unweave(ringb_floatdata_t *vec, float *src, int n) {
+  int i, m = min(vec[0].len, n);
+  for (i = 0; i < m; i++)
+    vec[0].buf[i] = src[2 * i];
+  for (; i < n; i++)
+    vec[1].buf[i - m] = src[2 * i];
+}
+
+/* @brief private setup_cvt
+ *
+ * converters both ways for a jack rate that isn't ours
+ *
+ * @return void
+ */
+
+PRIVATE void
+setup_cvt(int rate) {
+  int n = top->hold.size.frames,
+      ours = (int) uni->rate.sample,
+      most = max(ours, rate) / gcd(ours, rate);
+
+  top->snds.cvt.on = TRUE;
+  top->snds.cvt.rate = rate;
+  top->snds.cvt.have = 0;
+
+  top->snds.cvt.in = newCXB(jack_frames(n), NULL, "jack rate input");
+  top->snds.cvt.fifo = newCXB(fifo_frames(n), NULL, "dsp rate input");
+  top->snds.cvt.blk = newCXB(n, NULL, "dsp rate output");
+  top->snds.cvt.out = newCXB(jack_frames(n), NULL, "jack rate output");
+
+  top->snds.cvt.i = newPolyPhaseFIR(top->snds.cvt.in, jack_frames(n),
+				    top->snds.cvt.fifo,
+				    ours, rate,
+				    CVT_TAPS * most);
+  top->snds.cvt.o = newPolyPhaseFIR(top->snds.cvt.blk, n,
+				    top->snds.cvt.out,
+				    rate, ours,
+				    CVT_TAPS * most);
+}
+
+/* @brief private destroy_cvt
+ * @return void
+ */
+
+PRIVATE void
+destroy_cvt(void) {
+  delPolyPhaseFIR(top->snds.cvt.i);
+  delPolyPhaseFIR(top->snds.cvt.o);
+  delCXB(top->snds.cvt.in);
+  delCXB(top->snds.cvt.fifo);
+  delCXB(top->snds.cvt.blk);
+  delCXB(top->snds.cvt.out);
+  memset((char *) &top->snds.cvt, 0, sizeof(top->snds.cvt));
+}
+
+/* @brief private getcvt
+ *
+ * pull just enough off the input ring to finish a block at our rate;
+ * whatever runs over waits in the fifo for the next one
+ *
+ * @return BOOLEAN
+ */
+
+PRIVATE BOOLEAN
+getcvt(void) {
+  int i, n = top->hold.size.frames;
+  ResSt cv = top->snds.cvt.i;
+  COMPLEX *z = CXBbase(top->snds.cvt.fifo);
+
+  if (top->snds.cvt.have < n) {
+    int m = ((n - top->snds.cvt.have - 1) * cv->decim + cv->phase) / cv->intrp + 1;
+    ringb_floatdata_t l[2], r[2];
+
+    if ((ringb_float_read_space(top->snds.ring.i.l) < m) ||
+	(ringb_float_read_space(top->snds.ring.i.r) < m))
+      return FALSE;
+
+    ringb_float_get_read_vector(top->snds.ring.i.l, l);
+    ringb_float_get_read_vector(top->snds.ring.i.r, r);
+    weave((float *) CXBbase(top->snds.cvt.in), l, m);
+    weave((float *) CXBbase(top->snds.cvt.in) + 1, r, m);
+    ringb_float_read_advance(top->snds.ring.i.l, m);
+    ringb_float_read_advance(top->snds.ring.i.r, m);
+
+    cv->nnew = m;
+    cv->out = z + top->snds.cvt.have;
+    PolyPhaseFIR(cv);
+    top->snds.cvt.have += cv->nout;
+  }
+
+  for (i = 0; i < n; i++)
+    top->hold.buf.l[i] = z[i].re,
+    top->hold.buf.r[i] = z[i].im;
+  top->snds.cvt.have -= n;
+  memmove((char *) z, (char *) (z + n), top->snds.cvt.have * sizeof(COMPLEX));
+
+  top->hold.in = top->hold.out = top->hold.buf;
+  return TRUE;
+}
+
+/* @brief private putcvt
+ * @return void
+ */
+
+PRIVATE void
+putcvt(void) {
+  int i, m, n = top->hold.size.frames;
+  ResSt cv = top->snds.cvt.o;
+  ringb_floatdata_t l[2], r[2];
+
+  for (i = 0; i < n; i++)
+    CXBreal(top->snds.cvt.blk, i) = top->hold.buf.l[i],
+    CXBimag(top->snds.cvt.blk, i) = top->hold.buf.r[i];
+  cv->nnew = n;
+  PolyPhaseFIR(cv);
+  m = cv->nout;
+
+  if ((ringb_float_write_space(top->snds.ring.o.l) >= m) &&
+      (ringb_float_write_space(top->snds.ring.o.r) >= m)) {
+    ringb_float_get_write_vector(top->snds.ring.o.l, l);
+    ringb_float_get_write_vector(top->snds.ring.o.r, r);
+    unweave(l, (float *) CXBbase(top->snds.cvt.out), m);
+    unweave(r, (float *) CXBbase(top->snds.cvt.out) + 1, m);
+    ringb_float_write_advance(top->snds.ring.o.l, m);
+    ringb_float_write_advance(top->snds.ring.o.r, m);
+  }
+}
+
+//------------------------------------------------------------------------
+
+// DSP works directly on the ring regions when they're contiguous,
+// falls back to the hold buffers at the wrap.
+// Both rings start at a block boundary and move a block at a time,
+// and blocks divide the ring, so the wrap only comes up for a
+// little while after a buffer length change, until the rings
+// are next restarted
+
 PRIVATE BOOLEAN
 gethold(void) {
-  if ((ringb_float_read_space(top->snds.ring.i.l) >= top->hold.size.frames) &&
-      (ringb_float_read_space(top->snds.ring.i.r) >= top->hold.size.frames)) {
-    ringb_float_read(top->snds.ring.i.l, top->hold.buf.l, top->hold.size.frames);
-    ringb_float_read(top->snds.ring.i.r, top->hold.buf.r, top->hold.size.frames);
-    return TRUE;
-  } else
+  int n = top->hold.size.frames;
+  ringb_floatdata_t l[2], r[2];
+
+  if (top->snds.cvt.on)
+    return getcvt();
+
+  if ((ringb_float_read_space(top->snds.ring.i.l) < n) ||
+      (ringb_float_read_space(top->snds.ring.i.r) < n))
     return FALSE;
+
+  ringb_float_get_read_vector(top->snds.ring.i.l, l);
+  ringb_float_get_read_vector(top->snds.ring.i.r, r);
+  if (l[0].len >= n && r[0].len >= n)
+    top->hold.in.l = l[0].buf, top->hold.in.r = r[0].buf;
+  else {
+    gather(top->hold.buf.l, l, n);
+    gather(top->hold.buf.r, r, n);
+    top->hold.in = top->hold.buf;
+  }
+
+  ringb_float_get_write_vector(top->snds.ring.o.l, l);
+  ringb_float_get_write_vector(top->snds.ring.o.r, r);
+  if (l[0].len >= n && r[0].len >= n)
+    top->hold.out.l = l[0].buf, top->hold.out.r = r[0].buf;
+  else
+    top->hold.out = top->hold.buf;
+
+  return TRUE;
 }
 
 /* @brief private puthold 
@@ -559,8 +860,19 @@ gethold(void) {
 
 PRIVATE void
 puthold(void) {
-  if ((ringb_float_write_space(top->snds.ring.o.l) >= top->hold.size.frames) &&
-      (ringb_float_write_space(top->snds.ring.o.r) >= top->hold.size.frames)) {
+  if (top->snds.cvt.on) {
+    putcvt();
+    return;
+  }
+
+  ringb_float_read_advance(top->snds.ring.i.l, top->hold.size.frames);
+  ringb_float_read_advance(top->snds.ring.i.r, top->hold.size.frames);
+
+  if (top->hold.out.l != top->hold.buf.l) {
+    ringb_float_write_advance(top->snds.ring.o.l, top->hold.size.frames);
+    ringb_float_write_advance(top->snds.ring.o.r, top->hold.size.frames);
+  } else if ((ringb_float_write_space(top->snds.ring.o.l) >= top->hold.size.frames) &&
+	     (ringb_float_write_space(top->snds.ring.o.r) >= top->hold.size.frames)) {
     ringb_float_write(top->snds.ring.o.l,
 		      top->hold.buf.l,
 		      top->hold.size.frames);
@@ -570,6 +882,82 @@ puthold(void) {
   }
 }
 
+/* @brief private run_state
+ * @return void
+ */
+
+PRIVATE void
+run_state(void) {
+  switch (top->state) {
+  case RUN_MUTE: run_mute(); break;
+  case RUN_PASS: run_pass(); break;
+  case RUN_PLAY: run_play(); break;
+  case RUN_SWCH: run_swch(); break;
+  case RUN_TEST: run_test(); break;
+  }
+}
+
+// buffer length change in progress,
+// built by resize_thread, swapped in by the DSP thread
+
+PRIVATE struct {
+  int len;
+  BOOLEAN busy, ready;
+  float *l, *r;
+  CXB tone, twoa, twob;
+  struct {
+    CXB in, fifo, blk, out;
+    COMPLEX *hi, *ho;
+  } cvt;
+} rsz;
+
+/* @brief private check_resize
+ *
+ * at a buffer boundary, swap in a new buffer length
+ * if one is waiting, then let the builder clean up
+ *
+ * @return void
+ */
+
+PRIVATE void
+check_resize(void) {
+  if (__sync_fetch_and_add(&rsz.ready, 0)) {
+    float *l = top->hold.buf.l, *r = top->hold.buf.r;
+
+    swap_for_buflen();
+
+    top->hold.buf.l = rsz.l, rsz.l = l;
+    top->hold.buf.r = rsz.r, rsz.r = r;
+    top->hold.size.frames = rsz.len;
+    top->hold.size.bytes = rsz.len * sizeof(float);
+    top->hold.in = top->hold.out = top->hold.buf;
+
+    rsz.tone = (CXB) resizeOSC(top->test.tone.gen, rsz.tone, rsz.len);
+    rsz.twoa = (CXB) resizeOSC(top->test.twotone.a.gen, rsz.twoa, rsz.len);
+    rsz.twob = (CXB) resizeOSC(top->test.twotone.b.gen, rsz.twob, rsz.len);
+
+    if (top->snds.cvt.on) {
+      CXB t;
+      memcpy((char *) CXBbase(rsz.cvt.fifo),
+	     (char *) CXBbase(top->snds.cvt.fifo),
+	     top->snds.cvt.have * sizeof(COMPLEX));
+      t = top->snds.cvt.in, top->snds.cvt.in = rsz.cvt.in, rsz.cvt.in = t;
+      t = top->snds.cvt.fifo, top->snds.cvt.fifo = rsz.cvt.fifo, rsz.cvt.fifo = t;
+      t = top->snds.cvt.blk, top->snds.cvt.blk = rsz.cvt.blk, rsz.cvt.blk = t;
+      t = top->snds.cvt.out, top->snds.cvt.out = rsz.cvt.out, rsz.cvt.out = t;
+      top->snds.cvt.i->inp = CXBbase(top->snds.cvt.in);
+      top->snds.cvt.o->inp = CXBbase(top->snds.cvt.blk);
+      top->snds.cvt.o->out = CXBbase(top->snds.cvt.out);
+      rsz.cvt.hi = resizePolyPhaseFIR(top->snds.cvt.i, rsz.cvt.hi, jack_frames(rsz.len));
+      rsz.cvt.ho = resizePolyPhaseFIR(top->snds.cvt.o, rsz.cvt.ho, rsz.len);
+    }
+
+    // only now is it safe to build against what's running
+    __sync_bool_compare_and_swap(&rsz.ready, TRUE, FALSE);
+    sem_post(top->sync.bld.sem);
+  }
+}
+
 /* @brief private process_samples_thread
  * @return void
  */
@@ -578,20 +966,342 @@ PRIVATE void
 process_samples_thread(void) {
   while (top->running) {
     sem_wait(top->sync.buf.sem);
+    // run synchronous updates here, between buffers
+    drain_updates();
+    check_resize();
     while (gethold()) {
-      sem_wait(top->sync.upd.sem);
-      // run synchronous updates here
-      switch (top->state) {
-      case RUN_MUTE: run_mute(); break;
-      case RUN_PASS: run_pass(); break;
-      case RUN_PLAY: run_play(); break;
-      case RUN_SWCH: run_swch(); break;
-      case RUN_TEST: run_test(); break;
-      }
-      sem_post(top->sync.upd.sem);
+      struct timespec t0, t1;
+      double usec;
+
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      run_state();
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+
+      // did we take longer than the buffer lasts?
+      usec = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+      if (usec > top->snds.stat.worst)
+	top->snds.stat.worst = usec;
+      if (usec > 1e6 * top->hold.size.frames / uni->rate.sample)
+	top->snds.stat.late++;
+      top->snds.stat.pass++;
+
       puthold();
+      drain_updates();
+      check_resize();
+    }
+  }
+}
+
+//========================================================================
+// batch mode:
+// straight from one file to another, no jack, no rings, no threads,
+// as fast as we can go.
+// .wav files are 2-channel PCM (16/24/32) or float on input,
+// always float on output; anything else is raw interleaved float L/R.
+
+PRIVATE struct {
+  FILE *ifp, *ofp;
+  BOOLEAN iwav, owav;
+  int fmt, bits, bpf;
+  unsigned long left, rate;
+  long long frames, wrote;
+  unsigned char *io;
+} bat;
+
+PRIVATE BOOLEAN
+is_wav_path(char *path) {
+  int n = strlen(path);
+  return n > 4 && strcasecmp(path + n - 4, ".wav") == 0;
+}
+
+PRIVATE unsigned long
+le_get(unsigned char *b, int n) {
+  unsigned long v = 0;
+  while (n-- > 0)
+    v = (v << 8) | b[n];
+  return v;
+}
+
+PRIVATE void
+le_put(unsigned char *b, unsigned long v, int n) {
+  int i;
+  for (i = 0; i < n; i++, v >>= 8)
+    b[i] = v & 0xFF;
+}
+
+PRIVATE void
+batch_bail(char *msg) {
+  fprintf(stderr, "%s: %s: %s\n", top->snds.name, loc.path.input, msg);
+  exit(1);
+}
+
+/* @brief private open_batch_input
+ * find the fmt and data chunks of a .wav, or just open a raw file
+ * @return void
+ */
+
+PRIVATE void
+open_batch_input(void) {
+  if (strcmp(loc.path.input, "-") == 0)
+    bat.ifp = stdin;
+  else
+    bat.ifp = efopen(loc.path.input, "r");
+
+  if ((bat.iwav = is_wav_path(loc.path.input))) {
+    unsigned char hdr[40];
+    int chan = 0;
+
+    if (fread(hdr, 1, 12, bat.ifp) != 12 ||
+	memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4))
+      batch_bail("not a RIFF/WAVE file");
+
+    bat.fmt = 0;
+    for (;;) {
+      unsigned long size;
+      if (fread(hdr, 1, 8, bat.ifp) != 8)
+	batch_bail("no data chunk");
+      size = le_get(hdr + 4, 4);
+
+      if (memcmp(hdr, "fmt ", 4) == 0) {
+	int n = min(size, sizeof(hdr));
+	if (size < 16 || fread(hdr, 1, n, bat.ifp) != n)
+	  batch_bail("short fmt chunk");
+	bat.fmt = le_get(hdr, 2);
+	chan = le_get(hdr + 2, 2);
+	bat.rate = le_get(hdr + 4, 4);
+	bat.bits = le_get(hdr + 14, 2);
+	// WAVE_FORMAT_EXTENSIBLE, real format is in the subformat GUID
+	if (bat.fmt == 0xFFFE && n >= 26)
+	  bat.fmt = le_get(hdr + 24, 2);
+	fseek(bat.ifp, size - n + (size & 1), SEEK_CUR);
+
+      } else if (memcmp(hdr, "data", 4) == 0) {
+	bat.left = size;
+	break;
+
+      } else
+	fseek(bat.ifp, size + (size & 1), SEEK_CUR);
+    }
+
+    if (chan != 2)
+      batch_bail("need 2 channels");
+    if (!((bat.fmt == 1 && (bat.bits == 16 || bat.bits == 24 || bat.bits == 32)) ||
+	  (bat.fmt == 3 && bat.bits == 32)))
+      batch_bail("need 16/24/32 bit PCM or 32 bit float samples");
+    bat.bpf = 2 * bat.bits / 8;
+
+    // run at the rate the file was recorded at
+    if ((REAL) bat.rate != loc.def.rate) {
+      if (top->verbose)
+	fprintf(stderr, "%s: using file rate %lu\n", top->snds.name, bat.rate);
+      loc.def.rate = bat.rate;
+    }
+
+  } else {
+    bat.fmt = 3, bat.bits = 32;
+    bat.bpf = 2 * sizeof(float);
+    bat.left = ~0UL;
+  }
+}
+
+/* @brief private open_batch_output
+ * @return void
+ */
+
+PRIVATE void
+open_batch_output(void) {
+  if (strcmp(loc.path.output, "-") == 0)
+    bat.ofp = stdout;
+  else
+    bat.ofp = efopen(loc.path.output, "w");
+
+  // header now, sizes patched up at the end
+  if ((bat.owav = is_wav_path(loc.path.output))) {
+    unsigned char hdr[44];
+    memcpy(hdr, "RIFF", 4);
+    le_put(hdr + 4, 36, 4);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    le_put(hdr + 16, 16, 4);
+    le_put(hdr + 20, 3, 2);	// IEEE float
+    le_put(hdr + 22, 2, 2);
+    le_put(hdr + 24, (unsigned long) uni->rate.sample, 4);
+    le_put(hdr + 28, (unsigned long) uni->rate.sample * 2 * sizeof(float), 4);
+    le_put(hdr + 32, 2 * sizeof(float), 2);
+    le_put(hdr + 34, 8 * sizeof(float), 2);
+    memcpy(hdr + 36, "data", 4);
+    le_put(hdr + 40, 0, 4);
+    fwrite(hdr, 1, sizeof(hdr), bat.ofp);
+  }
+
+  bat.io = (unsigned char *) safealloc(top->hold.size.frames,
+				       max(bat.bpf, 2 * sizeof(float)),
+				       "batch io buffer");
+}
+
+/* @brief private close_batch
+ * @return void
+ */
+
+PRIVATE void
+close_batch(void) {
+  if (bat.owav) {
+    unsigned long dbytes = bat.wrote * 2 * sizeof(float);
+    unsigned char buf[4];
+    if (fseek(bat.ofp, 4, SEEK_SET) == 0) {
+      le_put(buf, 36 + dbytes, 4);
+      fwrite(buf, 1, 4, bat.ofp);
+      fseek(bat.ofp, 40, SEEK_SET);
+      le_put(buf, dbytes, 4);
+      fwrite(buf, 1, 4, bat.ofp);
+    }
+  }
+  if (bat.ofp != stdout)
+    fclose(bat.ofp);
+  if (bat.ifp != stdin)
+    fclose(bat.ifp);
+  safefree((char *) bat.io);
+}
+
+/* @brief private read_batch
+ * @return number of frames read
+ */
+
+PRIVATE int
+read_batch(float *l, float *r, int n) {
+  int i, got;
+
+  n = min(n, bat.left / bat.bpf);
+  if (n <= 0 || (got = fread(bat.io, bat.bpf, n, bat.ifp)) <= 0)
+    return 0;
+  bat.left -= got * bat.bpf;
+
+  switch (bat.bits) {
+  case 16:
+    for (i = 0; i < got; i++)
+      l[i] = (short) le_get(bat.io + 4 * i, 2) / 32768.0,
+      r[i] = (short) le_get(bat.io + 4 * i + 2, 2) / 32768.0;
+    break;
+  case 24:
+    for (i = 0; i < got; i++) {
+      long a = le_get(bat.io + 6 * i, 3), b = le_get(bat.io + 6 * i + 3, 3);
+      if (a & 0x800000) a -= 0x1000000;
+      if (b & 0x800000) b -= 0x1000000;
+      l[i] = a / 8388608.0, r[i] = b / 8388608.0;
+    }
+    break;
+  case 32:
+    if (bat.fmt == 3) {
+      float *f = (float *) bat.io;
+      for (i = 0; i < got; i++)
+	l[i] = f[2 * i], r[i] = f[2 * i + 1];
+    } else
+      for (i = 0; i < got; i++)
+	l[i] = (int) le_get(bat.io + 8 * i, 4) / 2147483648.0,
+	r[i] = (int) le_get(bat.io + 8 * i + 4, 4) / 2147483648.0;
+    break;
+  }
+
+  return got;
+}
+
+/* @brief private write_batch
+ * @return void
+ */
+
+PRIVATE void
+write_batch(float *l, float *r, int n) {
+  float *f = (float *) bat.io;
+  int i;
+  for (i = 0; i < n; i++)
+    f[2 * i] = l[i], f[2 * i + 1] = r[i];
+  if (fwrite(f, 2 * sizeof(float), n, bat.ofp) != n) {
+    perror(loc.path.output);
+    exit(1);
+  }
+  bat.wrote += n;
+}
+
+/* @brief private execute_batch
+ * @return void
+ */
+
+PRIVATE void
+execute_batch(void) {
+  struct timeval t0, t1, dt;
+  int got, last = 0;
+  double wall, secs;
+
+  // rcfile
+  {
+    FILE *frc = find_rcfile(loc.path.rcfile);
+    if (frc) {
+      while (fgets(top->parm.buff, sizeof(top->parm.buff), frc))
+	do_update(top->parm.buff, top->echo.fp ? stderr : 0);
+      fclose(frc);
     }
   }
+
+  t0 = now_tv();
+
+  while (top->running &&
+	 (got = read_batch(top->hold.buf.l,
+			   top->hold.buf.r,
+			   top->hold.size.frames)) > 0) {
+    // pad out the last short block
+    if (got < top->hold.size.frames) {
+      memset((char *) (top->hold.buf.l + got), 0,
+	     (top->hold.size.frames - got) * sizeof(float));
+      memset((char *) (top->hold.buf.r + got), 0,
+	     (top->hold.size.frames - got) * sizeof(float));
+    }
+    run_state();
+    write_batch(top->hold.buf.l, top->hold.buf.r, got);
+    bat.frames += got;
+    last = got;
+  }
+
+  // the end of the input is still in the filters;
+  // run zeros through for their delay to get it out,
+  // starting with what the padding already brought
+  if (bat.frames > 0) {
+    int n = top->hold.size.frames, left = chain_delay(), w;
+
+    if (last < n) {
+      w = min(left, n - last);
+      write_batch(top->hold.buf.l + last, top->hold.buf.r + last, w);
+      left -= w;
+    }
+    while (top->running && left > 0) {
+      memset((char *) top->hold.buf.l, 0, top->hold.size.bytes);
+      memset((char *) top->hold.buf.r, 0, top->hold.size.bytes);
+      run_state();
+      w = min(left, n);
+      write_batch(top->hold.buf.l, top->hold.buf.r, w);
+      left -= w;
+    }
+  }
+
+  t1 = now_tv();
+  dt = diff_tv(&t1, &t0);
+  wall = dt.tv_sec + dt.tv_usec / 1e6;
+  secs = bat.frames / uni->rate.sample;
+  fprintf(stderr,
+	  "%s: %lld frames, %.3f s of signal in %.3f s, %.1fx real time\n",
+	  top->snds.name, bat.frames, secs, wall,
+	  wall > 0.0 ? secs / wall : 0.0);
+
+  // stage timing, if it was asked for
+  if (uni->stats.flag) {
+    int k;
+    for (k = 0; k < uni->multirx.nrx; k++)
+      if (uni->multirx.act[k]) {
+	sprintf(top->parm.buff, "-getStats %d %d", RX, k);
+	if (do_update(top->parm.buff, 0) == 0)
+	  fputs(top->resp.buff, stderr);
+      }
+  }
+
+  close_batch();
 }
 
 //========================================================================
@@ -621,17 +1331,29 @@ execute(void) {
 
   // issue cancellation notices
   pthread_cancel(top->thrd.trx.id);
+  pthread_cancel(top->thrd.dsg.id);
   if (uni->meter.flag)
     pthread_cancel(top->thrd.mtr.id);
-  if (uni->spec.flag)
+  if (uni->multispec.flag)
     pthread_cancel(top->thrd.pws.id);
+  if (uni->multirx.par) {
+    int k;
+    for (k = 0; k < uni->multirx.nrx; k++)
+      pthread_cancel(top->thrd.rxw[k].id);
+  }
 
   // wait for remaining threads to finish
   pthread_join(top->thrd.trx.id, 0);
+  pthread_join(top->thrd.dsg.id, 0);
   if (uni->meter.flag)
     pthread_join(top->thrd.mtr.id, 0);
-  if (uni->spec.flag)
+  if (uni->multispec.flag)
     pthread_join(top->thrd.pws.id, 0);
+  if (uni->multirx.par) {
+    int k;
+    for (k = 0; k < uni->multirx.nrx; k++)
+      pthread_join(top->thrd.rxw[k].id, 0);
+  }
   
   // stop audio processing
   jack_client_close(top->snds.client);
@@ -651,6 +1373,7 @@ setup_local_audio(void) {
   top->hold.buf.r = (float *) safealloc(top->hold.size.frames,
 					sizeof(float),
 					"main hold buffer right");
+  top->hold.in = top->hold.out = top->hold.buf;
 
   // test generators
 
@@ -697,7 +1420,7 @@ setup_updates(void) {
   // do this here 'cuz the update thread is controlling the action
   if (uni->meter.flag)
     top->meas.mtr.port = loc.port.meter;
-  if (uni->spec.flag)
+  if (uni->multispec.flag)
     top->meas.spec.port = loc.port.spec;
 
   if ((uni->update.path = loc.path.replay)) {
@@ -729,7 +1452,7 @@ setup_updates(void) {
  */
 
 PRIVATE void
-jack_xrun(void *arg) {}
+jack_xrun(void *arg) { top->snds.stat.xrun++; }
 
 PRIVATE void
 jack_shutdown(void *arg) {}
@@ -747,13 +1470,14 @@ setup_system_audio(void) {
     exit(1);
   }
 
+  // run at our own rate regardless, converting at the rings
   if ((jack_nframes_t) loc.def.rate != jack_get_sample_rate(top->snds.client)) {
-    fprintf(stderr, "In %s:\n", top->snds.name);
-    fprintf(stderr, "There's a sample rate mismatch.\n");
-    fprintf(stderr, "dttsp rate is %d.\n", (jack_nframes_t) loc.def.rate);
-    fprintf(stderr, "jackd rate is %d.\n", jack_get_sample_rate(top->snds.client));
-    fprintf(stderr, "Time to exit so you can straighten this out.\n");
-    exit(1);
+    setup_cvt(jack_get_sample_rate(top->snds.client));
+    if (top->verbose)
+      fprintf(stderr, "%s: converting jackd %d <-> dttsp %d\n",
+	      top->snds.name,
+	      top->snds.cvt.rate,
+	      (int) loc.def.rate);
   }
 
   jack_set_process_callback(top->snds.client, (void *) audio_callback, 0);
@@ -783,7 +1507,12 @@ setup_system_audio(void) {
 					  0);
 
   {
-    int nr = nblock2(max(top->hold.size.frames, top->snds.size) * loc.mult.ring);
+    int nj = jack_frames(top->hold.size.frames), nr;
+    // converted blocks don't line up with jack periods,
+    // so leave room for one more on top
+    if (top->snds.cvt.on)
+      nj += top->snds.size;
+    nr = nblock2(max(nj, top->snds.size) * loc.mult.ring);
     top->snds.ring.i.l = ringb_float_create(nr);
     top->snds.ring.i.r = ringb_float_create(nr);
     top->snds.ring.o.l = ringb_float_create(nr);
@@ -812,24 +1541,106 @@ make_sem(char *id, char *path) {
  * @return void
  */
 
+/* @brief private set_thread_rt
+ *
+ * realtime priority and cpu pinning, if asked for;
+ * failure (usually no rtprio rights) is reported but not fatal
+ *
+ * @return void
+ */
+
+PRIVATE void
+set_thread_rt(pthread_t id, char *what, int prio, int cpu) {
+  int err;
+
+  if (prio > 0) {
+    struct sched_param sp;
+    memset((char *) &sp, 0, sizeof(sp));
+    sp.sched_priority = prio;
+    if ((err = pthread_setschedparam(id, SCHED_FIFO, &sp)))
+      fprintf(stderr, "%s: can't set %s to SCHED_FIFO %d: %s\n",
+	      top->snds.name, what, prio, strerror(err));
+  }
+
+#ifdef CPU_SET
+  if (cpu >= 0) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if ((err = pthread_setaffinity_np(id, sizeof(set), &set)))
+      fprintf(stderr, "%s: can't pin %s to cpu %d: %s\n",
+	      top->snds.name, what, cpu, strerror(err));
+  }
+#endif
+
+  if (top->verbose)
+    fprintf(stderr, "%s: %s prio %d cpu %d\n", top->snds.name, what, prio, cpu);
+}
+
+/* @brief private lock_memory
+ *
+ * MCL_CURRENT faults in and pins the workspace built so far,
+ * MCL_FUTURE does the same for thread stacks and anything
+ * allocated later (buflen changes etc.)
+ *
+ * @return void
+ */
+
+PRIVATE void
+lock_memory(void) {
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1)
+    perror("Can't lock memory");
+}
+
 PRIVATE void
 setup_threading(void) {
-  top->sync.upd.sem = make_sem("update", top->sync.upd.name);
-  pthread_create(&top->thrd.upd.id, 0, (void *) process_updates_thread, 0);
+  if (loc.rt.lock)
+    lock_memory();
 
+  top->sync.upd.sem = make_sem("update", top->sync.upd.name);
+  top->sync.ack.sem = make_sem("ack", top->sync.ack.name);
   top->sync.buf.sem = make_sem("buffer", top->sync.buf.name);
+  top->sync.bld.sem = make_sem("resize", top->sync.bld.name);
+  top->sync.dsg.sem = make_sem("design", top->sync.dsg.name);
+  pthread_create(&top->thrd.dsg.id, 0, (void *) design_thread, 0);
   pthread_create(&top->thrd.trx.id, 0, (void *) process_samples_thread, 0);
+  set_thread_rt(top->thrd.trx.id, "trx", loc.rt.trx.prio, loc.rt.trx.cpu);
+
+  // from here on, commands are handed to the DSP thread
+  top->defer = TRUE;
+  pthread_create(&top->thrd.upd.id, 0, (void *) process_updates_thread, 0);
+  set_thread_rt(top->thrd.upd.id, "upd", loc.rt.upd.prio, loc.rt.upd.cpu);
+
+  // one worker per receiver, all idle until process_samples kicks them
+  if ((uni->multirx.par = loc.par.rx)) {
+    int k;
+    top->sync.rxd.sem = make_sem("rxdone", top->sync.rxd.name);
+    for (k = 0; k < uni->multirx.nrx; k++) {
+      char id[16];
+      sprintf(id, "rxgo%d", k);
+      top->sync.rxw[k].sem = make_sem(id, top->sync.rxw[k].name);
+      pthread_create(&top->thrd.rxw[k].id, 0,
+		     (void *) rx_worker_thread, (void *) (long) k);
+      // workers fan out from the base cpu
+      sprintf(id, "rxw%d", k);
+      set_thread_rt(top->thrd.rxw[k].id, id,
+		    loc.rt.rxw.prio,
+		    loc.rt.rxw.cpu < 0 ? -1 : loc.rt.rxw.cpu + k);
+    }
+  }
 
   top->susp = FALSE;
 
   if (uni->meter.flag) {
     top->sync.mtr.sem = make_sem("meter", top->sync.mtr.name);
     pthread_create(&top->thrd.mtr.id, 0, (void *) meter_thread, 0);
+    set_thread_rt(top->thrd.mtr.id, "mtr", loc.rt.mtr.prio, loc.rt.mtr.cpu);
   }
 
-  if (uni->spec.flag) {
+  if (uni->multispec.flag) {
     top->sync.pws.sem = make_sem("spectrum", top->sync.pws.name);
     pthread_create(&top->thrd.pws.id, 0, (void *) spectrum_thread, 0);
+    set_thread_rt(top->thrd.pws.id, "pws", loc.rt.pws.prio, loc.rt.pws.cpu);
   }
 }
 
@@ -838,7 +1649,20 @@ setup_threading(void) {
 // hard defaults, then environment
 /////////////////////////////////////
 
-/* @brief private execute 
+/* @brief private get_rt
+ *
+ * parse <prio>[,<cpu>]
+ *
+ * @return void
+ */
+
+PRIVATE void
+get_rt(char *s, int *prio, int *cpu) {
+  if (sscanf(s, "%d,%d", prio, cpu) < 2)
+    *cpu = -1;
+}
+
+/* @brief private execute
  * @return void
  */
 
@@ -847,18 +1671,26 @@ setup_defaults(void) {
   // no env vars for these
   loc.name[0] = 0; // no default for client name, period
   loc.path.echo[0] = 0;  // file defaults to stderr
+  loc.path.input[0] = loc.path.output[0] = 0; // batch mode off
 
   strcpy(loc.path.rcfile, RCBASE);
   strcpy(loc.path.replay, REPLAYPATH);
   strcpy(loc.path.wisdom, WISDOMPATH);
 
   loc.def.comp   = DEFCOMP;
+  loc.def.dec    = 1;
   loc.def.mode   = DEFMODE;
   loc.def.nrx    = MAXRX;
   loc.def.rate   = DEFRATE;
   loc.def.size   = DEFSIZE;
   loc.def.spec   = DEFSPEC;
   loc.mult.ring  = RINGMULT;
+  loc.par.rx     = FALSE;
+  loc.rt.trx.prio = loc.rt.upd.prio = loc.rt.mtr.prio = 0;
+  loc.rt.pws.prio = loc.rt.rxw.prio = 0;
+  loc.rt.trx.cpu  = loc.rt.upd.cpu  = loc.rt.mtr.cpu  = -1;
+  loc.rt.pws.cpu  = loc.rt.rxw.cpu  = -1;
+  loc.rt.lock    = FALSE;
   loc.skew.offs  = DEFOFFS;
   loc.port.spec  = SPECPORT;
   loc.port.meter = METERPORT;
@@ -869,10 +1701,18 @@ setup_defaults(void) {
     if ((ep = getenv("SDR_DEFMODE")))    loc.def.mode = atoi(ep);
     if ((ep = getenv("SDR_DEFRATE")))    loc.def.rate = atof(ep);
     if ((ep = getenv("SDR_DEFSIZE")))    loc.def.size = atoi(ep);
+    if ((ep = getenv("SDR_DECIMATE")))   loc.def.dec = atoi(ep);
     if ((ep = getenv("SDR_RINGMULT")))   loc.mult.ring = atoi(ep);
     if ((ep = getenv("SDR_SKEWOFFS")))   loc.skew.offs = atoi(ep);
     if ((ep = getenv("SDR_METERPORT")))  loc.port.meter = atoi(ep);
     if ((ep = getenv("SDR_NAME")))       strcpy(loc.name, ep);
+    if ((ep = getenv("SDR_PARALLELRX"))) loc.par.rx = atoi(ep);
+    if ((ep = getenv("SDR_MLOCK")))      loc.rt.lock = atoi(ep);
+    if ((ep = getenv("SDR_RTTRX")))      get_rt(ep, &loc.rt.trx.prio, &loc.rt.trx.cpu);
+    if ((ep = getenv("SDR_RTUPD")))      get_rt(ep, &loc.rt.upd.prio, &loc.rt.upd.cpu);
+    if ((ep = getenv("SDR_RTMTR")))      get_rt(ep, &loc.rt.mtr.prio, &loc.rt.mtr.cpu);
+    if ((ep = getenv("SDR_RTPWS")))      get_rt(ep, &loc.rt.pws.prio, &loc.rt.pws.cpu);
+    if ((ep = getenv("SDR_RTRXW")))      get_rt(ep, &loc.rt.rxw.prio, &loc.rt.rxw.cpu);
     if ((ep = getenv("SDR_PARMPORT")))   loc.port.parm = atoi(ep);
     if ((ep = getenv("SDR_RCBASE")))     strcpy(loc.path.rcfile, ep);
     if ((ep = getenv("SDR_REPLAYPATH"))) strcpy(loc.path.replay, ep);
@@ -883,6 +1723,85 @@ setup_defaults(void) {
 
 //========================================================================
 
+/* @brief settle_resize
+ *
+ * wait out a built buffer length change not yet swapped in.
+ * For anything holding upd that's about to build against
+ * the filters as they are, which the swap would replace.
+ * The DSP thread swaps at its next pass, and was woken for it.
+ *
+ * @return void
+ */
+
+void
+settle_resize(void) {
+  while (__sync_fetch_and_add(&rsz.ready, 0))
+    sched_yield();
+}
+
+/* @brief private resize_thread
+ *
+ * build the new-size workspace while the old one runs,
+ * holding off commands so nothing shifts underneath;
+ * let them go once it's ready, and free the leftovers
+ * when the DSP thread has swapped, under upd again
+ * since tearing down FFT plans shares the planner
+ *
+ * @return void
+ */
+
+PRIVATE void
+resize_thread(void) {
+  int len = rsz.len;
+
+  sem_wait(top->sync.upd.sem);
+
+  build_for_buflen(len);
+  rsz.l = (float *) safealloc(len, sizeof(float), "main hold buffer left");
+  rsz.r = (float *) safealloc(len, sizeof(float), "main hold buffer right");
+  rsz.tone = newCXB(len, NULL, "test tone buffer");
+  rsz.twoa = newCXB(len, NULL, "test 2tone buffer");
+  rsz.twob = newCXB(len, NULL, "test 2tone buffer");
+  if (top->snds.cvt.on) {
+    rsz.cvt.in = newCXB(jack_frames(len), NULL, "jack rate input");
+    rsz.cvt.fifo = newCXB(fifo_frames(len), NULL, "dsp rate input");
+    rsz.cvt.blk = newCXB(len, NULL, "dsp rate output");
+    rsz.cvt.out = newCXB(jack_frames(len), NULL, "jack rate output");
+    rsz.cvt.hi = newvec_COMPLEX(PolyPhaseFIR_histsize(top->snds.cvt.i, jack_frames(len)),
+				"jack rate input past");
+    rsz.cvt.ho = newvec_COMPLEX(PolyPhaseFIR_histsize(top->snds.cvt.o, len),
+				"dsp rate output past");
+  }
+
+  __sync_bool_compare_and_swap(&rsz.ready, FALSE, TRUE);
+  sem_post(top->sync.upd.sem);
+
+  // swap at the next pass, whether or not there's audio
+  sem_post(top->sync.buf.sem);
+  sem_wait(top->sync.bld.sem);
+
+  sem_wait(top->sync.upd.sem);
+  free_for_buflen();
+  safefree((char *) rsz.l);
+  safefree((char *) rsz.r);
+  delCXB(rsz.tone);
+  delCXB(rsz.twoa);
+  delCXB(rsz.twob);
+  delCXB(rsz.cvt.in);
+  delCXB(rsz.cvt.fifo);
+  delCXB(rsz.cvt.blk);
+  delCXB(rsz.cvt.out);
+  delvec_COMPLEX(rsz.cvt.hi);
+  delvec_COMPLEX(rsz.cvt.ho);
+  sem_post(top->sync.upd.sem);
+
+  if (top->verbose)
+    fprintf(stderr, "%s: buffer length now %d\n", top->snds.name, len);
+
+  __sync_bool_compare_and_swap(&rsz.busy, TRUE, FALSE);
+  pthread_exit(0);
+}
+
 int
 reset_for_buflen(int new_buflen) {
 
@@ -890,6 +1809,38 @@ reset_for_buflen(int new_buflen) {
   if (popcnt(new_buflen) != 1)
     return -1;
 
+  // and still leaves whole blocks after decimation
+  if (uni->rate.dec > 1 && new_buflen / uni->rate.dec < MINRXLEN)
+    return -1;
+
+  // and a buffer still fits in every spectrum tap's accumulator
+  {
+    int k;
+    for (k = 0; k < MAXSPEC; k++)
+      if (tap_spectrum(&uni->spec[k]) != SPEC_TAP_OFF
+	  && new_buflen > 8 * uni->spec[k].want)
+	return -1;
+  }
+
+  // running: build on the side, swap at a buffer boundary
+  if (top->defer) {
+    // has to fit in the rings along with a jack period
+    if (jack_frames(new_buflen) + top->snds.size >= top->snds.ring.i.l->size)
+      return -1;
+    if (!__sync_bool_compare_and_swap(&rsz.busy, FALSE, TRUE))
+      return -1;
+    if (new_buflen == uni->buflen) {
+      __sync_bool_compare_and_swap(&rsz.busy, TRUE, FALSE);
+      return 0;
+    }
+    rsz.len = new_buflen;
+    pthread_create(&top->thrd.bld.id, 0, (void *) resize_thread, 0);
+    pthread_detach(top->thrd.bld.id);
+    return 0;
+  }
+
+  // otherwise nothing's running yet, start over
+
   safefree((char *) top->hold.buf.r);
   safefree((char *) top->hold.buf.l);
 
@@ -936,11 +1887,6 @@ destroy_globals(void) {
 
 PRIVATE void 
 closeup(void) {
-  ringb_float_free(top->snds.ring.o.r);
-  ringb_float_free(top->snds.ring.o.l);
-  ringb_float_free(top->snds.ring.i.r);
-  ringb_float_free(top->snds.ring.i.l);
-
   safefree((char *) top->hold.buf.r);
   safefree((char *) top->hold.buf.l);
 
@@ -951,23 +1897,53 @@ closeup(void) {
   if (top->verbose && top->echo.fp != stderr)
     fclose(top->echo.fp);
 
+  if (uni->update.flag)
+    fclose(uni->update.fp);
+
+  // batch mode never got any further than this
+  if (loc.path.input[0]) {
+    destroy_workspace();
+    destroy_globals();
+    exit(0);
+  }
+
+  ringb_float_free(top->snds.ring.o.r);
+  ringb_float_free(top->snds.ring.o.l);
+  ringb_float_free(top->snds.ring.i.r);
+  ringb_float_free(top->snds.ring.i.l);
+  if (top->snds.cvt.on)
+    destroy_cvt();
+
   sem_close(top->sync.buf.sem);
   sem_unlink(top->sync.buf.name);
   sem_close(top->sync.upd.sem);
   sem_unlink(top->sync.upd.name);
+  sem_close(top->sync.ack.sem);
+  sem_unlink(top->sync.ack.name);
+  sem_close(top->sync.bld.sem);
+  sem_unlink(top->sync.bld.name);
+  sem_close(top->sync.dsg.sem);
+  sem_unlink(top->sync.dsg.name);
 
   if (uni->meter.flag) {
     sem_close(top->sync.mtr.sem);
     sem_unlink(top->sync.mtr.name);
   }
 
-  if (uni->spec.flag) {
+  if (uni->multispec.flag) {
     sem_close(top->sync.pws.sem);
     sem_unlink(top->sync.pws.name);
   }
 
-  if (uni->update.flag)
-    fclose(uni->update.fp);
+  if (uni->multirx.par) {
+    int k;
+    for (k = 0; k < uni->multirx.nrx; k++) {
+      sem_close(top->sync.rxw[k].sem);
+      sem_unlink(top->sync.rxw[k].name);
+    }
+    sem_close(top->sync.rxd.sem);
+    sem_unlink(top->sync.rxd.name);
+  }
 
   destroy_workspace();
 
@@ -998,6 +1974,16 @@ PRIVATE struct option long_options[] = {
   {"wisdom-path",   required_argument, 0, 14},
   {"echo-path",     required_argument, 0, 15},
   {"skewoffs",      required_argument, 0, 16},
+  {"parallel-rx",   no_argument,       0, 17},
+  {"batch-in",      required_argument, 0, 18},
+  {"batch-out",     required_argument, 0, 19},
+  {"rt-trx",        required_argument, 0, 20},
+  {"rt-upd",        required_argument, 0, 21},
+  {"rt-mtr",        required_argument, 0, 22},
+  {"rt-pws",        required_argument, 0, 23},
+  {"rt-rxw",        required_argument, 0, 24},
+  {"mlock",         no_argument,       0, 25},
+  {"decimate",      required_argument, 0, 26},
   {"help",          no_argument,       0, 99},
   {0,               0,                 0,  0}
 };
@@ -1027,7 +2013,7 @@ setup_from_commandline(int argc, char **argv) {
 
     case 1:
     case 's':
-      uni->spec.flag = TRUE;
+      uni->multispec.flag = TRUE;
       break;
 
     case 2:
@@ -1088,6 +2074,46 @@ setup_from_commandline(int argc, char **argv) {
       loc.skew.offs = atoi(optarg);
       break;
 
+    case 17:
+      loc.par.rx = TRUE;
+      break;
+
+    case 18:
+      strcpy(loc.path.input, optarg);
+      break;
+
+    case 19:
+      strcpy(loc.path.output, optarg);
+      break;
+
+    case 20:
+      get_rt(optarg, &loc.rt.trx.prio, &loc.rt.trx.cpu);
+      break;
+
+    case 21:
+      get_rt(optarg, &loc.rt.upd.prio, &loc.rt.upd.cpu);
+      break;
+
+    case 22:
+      get_rt(optarg, &loc.rt.mtr.prio, &loc.rt.mtr.cpu);
+      break;
+
+    case 23:
+      get_rt(optarg, &loc.rt.pws.prio, &loc.rt.pws.cpu);
+      break;
+
+    case 24:
+      get_rt(optarg, &loc.rt.rxw.prio, &loc.rt.rxw.cpu);
+      break;
+
+    case 25:
+      loc.rt.lock = TRUE;
+      break;
+
+    case 26:
+      loc.def.dec = atoi(optarg);
+      break;
+
     case 99:
     case 'h':
     default:
@@ -1112,6 +2138,29 @@ create_globals(void) {
  * @return void
  */
 
+/* @brief private check_decimation
+ *
+ * rx decimation has to be a power of 2 that leaves
+ * whole audio-rate blocks and enough bandwidth
+ *
+ * @return void
+ */
+
+PRIVATE void
+check_decimation(void) {
+  int dec = loc.def.dec;
+
+  if (dec > 1 && (popcnt(dec) != 1 ||
+		  loc.def.size / dec < MINRXLEN ||
+		  loc.def.rate / dec < MINRXRATE)) {
+    fprintf(stderr,
+	    "can't decimate by %d at rate %g, buffer size %d; not decimating\n",
+	    dec, loc.def.rate, loc.def.size);
+    dec = 1;
+  }
+  uni->rate.dec = max(dec, 1);
+}
+
 PRIVATE void
 setup(int argc, char **argv) {
   create_globals();
@@ -1121,6 +2170,7 @@ setup(int argc, char **argv) {
   top->start_tv = now_tv();
   top->running = TRUE;
   top->verbose = FALSE;
+  top->defer = FALSE;
   top->state = RUN_PLAY;
   top->offs = DEFOFFS;
   top->snds.doin = FALSE;
@@ -1136,6 +2186,17 @@ setup(int argc, char **argv) {
 
   setup_from_commandline(argc, argv);
 
+  // batch mode picks up the rate from the input file
+  if (loc.path.input[0]) {
+    if (!loc.path.output[0])
+      fprintf(stderr, "--batch-in needs --batch-out too\n"), exit(1);
+    open_batch_input();
+    // no one to report to
+    uni->meter.flag = uni->multispec.flag = FALSE;
+  }
+
+  check_decimation();
+
   setup_workspace(loc.def.rate,
 		  loc.def.size,
 		  loc.def.mode,
@@ -1147,6 +2208,16 @@ setup(int argc, char **argv) {
   setup_updates();
 
   setup_local_audio();
+
+  if (loc.path.input[0]) {
+    if (loc.name[0])
+      strcpy(top->snds.name, loc.name);
+    else
+      sprintf(top->snds.name, "sdr-%d", top->pid);
+    open_batch_output();
+    return;
+  }
+
   setup_system_audio();
 
   setup_threading();
@@ -1160,7 +2231,12 @@ setup(int argc, char **argv) {
 
 int 
 main(int argc, char **argv) {
-  setup(argc, argv), execute(), closeup();
+  setup(argc, argv);
+  if (loc.path.input[0])
+    execute_batch();
+  else
+    execute();
+  closeup();
   return 0;
 } 
 
@@ -1207,6 +2283,25 @@ usage(void) {
   fprintf(stderr, "	Write update command processor output to <path>\n");
   fprintf(stderr, "--skewoffs=<+/-num>\n");
   fprintf(stderr, "	Correct for audio channel skew by <num>\n");
+  fprintf(stderr, "--parallel-rx\n");
+  fprintf(stderr, "	Run each active receiver on its own worker thread\n");
+  fprintf(stderr, "--batch-in=<path>\n");
+  fprintf(stderr, "	Process <path> offline instead of running under jack\n");
+  fprintf(stderr, "	.wav is 2-channel PCM or float, otherwise raw float L/R\n");
+  fprintf(stderr, "--batch-out=<path>\n");
+  fprintf(stderr, "	Write batch output to <path>, float .wav or raw float L/R\n");
+  fprintf(stderr, "--decimate=<power-of-2>\n");
+  fprintf(stderr, "	Run the receivers past their filters at 1/<power-of-2> the rate\n");
+  fprintf(stderr, "--rt-trx=<prio>[,<cpu>]\n");
+  fprintf(stderr, "	Run the DSP thread SCHED_FIFO at <prio>, pinned to <cpu>\n");
+  fprintf(stderr, "--rt-upd=<prio>[,<cpu>]\n");
+  fprintf(stderr, "--rt-mtr=<prio>[,<cpu>]\n");
+  fprintf(stderr, "--rt-pws=<prio>[,<cpu>]\n");
+  fprintf(stderr, "	Same for the update, meter & spectrum threads\n");
+  fprintf(stderr, "--rt-rxw=<prio>[,<cpu>]\n");
+  fprintf(stderr, "	Same for the receiver workers, worker k on <cpu>+k\n");
+  fprintf(stderr, "--mlock\n");
+  fprintf(stderr, "	Lock all memory, present & future, into RAM\n");
   fprintf(stderr, "--help\n");
   fprintf(stderr, " -h\n");
   fprintf(stderr, "	Write this message and exit.\n");
@@ -1218,6 +2313,9 @@ usage(void) {
   fprintf(stderr, "\tSDR_SKEWOFFS\n");
   fprintf(stderr, "\tSDR_METERPORT\n");
   fprintf(stderr, "\tSDR_NAME\n");
+  fprintf(stderr, "\tSDR_PARALLELRX\n");
+  fprintf(stderr, "\tSDR_MLOCK\n");
+  fprintf(stderr, "\tSDR_RTTRX, SDR_RTUPD, SDR_RTMTR, SDR_RTPWS, SDR_RTRXW\n");
   fprintf(stderr, "\tSDR_PARMPORT\n");
   fprintf(stderr, "\tSDR_RCBASE\n");
   fprintf(stderr, "\tSDR_REPLAYPATH\n");
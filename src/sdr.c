@@ -64,8 +64,11 @@ reset_meters(void) {
 /* ---------------------------------------------------------------------------- */
 void
 reset_spectrum(void) {
-  if (uni->spec.flag)
-    reinit_spectrum(&uni->spec);
+  int k;
+  if (uni->multispec.flag)
+    for (k = 0; k < MAXSPEC; k++)
+      if (tap_spectrum(&uni->spec[k]) == SPEC_TAP_ON)
+	reinit_spectrum(&uni->spec[k]);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -111,6 +114,8 @@ setup_all(REAL samplerate,
 	  int cpdsize) {
 
   uni->rate.sample = samplerate;
+  if (uni->rate.dec < 1)
+    uni->rate.dec = 1;
   uni->buflen = buflen;
   uni->mode.sdr = mode;
   uni->mode.trx = RX;
@@ -129,19 +134,36 @@ setup_all(REAL samplerate,
   if (uni->meter.flag)
     reset_meters();
 
-  uni->spec.rxk = 0;
-  uni->spec.buflen = uni->buflen;
-  uni->spec.scale = SPEC_PWR;
-  uni->spec.type = SPEC_POST_FILT;
-  uni->spec.size = specsize;
-  uni->spec.planbits = uni->wisdom.bits;
-  init_spectrum(&uni->spec);
+  // every tap starts out like the first; only that one is on
+  {
+    int k;
+    for (k = 0; k < MAXSPEC; k++) {
+      SpecBlock *sb = &uni->spec[k];
+      sb->rxk = 0;
+      sb->buflen = uni->buflen;
+      sb->scale = SPEC_PWR;
+      sb->type = SPEC_POST_FILT;
+      sb->size = sb->want = specsize;
+      sb->rate = uni->rate.sample;
+      sb->planbits = uni->wisdom.bits;
+      sb->wintype = BLACKMANHARRIS_WINDOW;
+      sb->polyphase = FALSE;
+      sb->view.alpha = 0.8f;
+      sb->state = SPEC_TAP_OFF;
+    }
+    init_spectrum(&uni->spec[0]);
+    uni->spec[0].state = SPEC_TAP_ON;
+    uni->multispec.sel = 0;
+  }
 
   // set which receiver is listening to commands
   uni->multirx.lis = 0;
   uni->multirx.nrx = numrecv;
+  uni->multirx.buf = newCXB(buflen, 0, "shared rx input");
 
   uni->cpdlen = cpdsize;
+  uni->filt.fade = FALSE;
+  uni->filt.cache = newFiltCache(FILTCACHE_SIZE);
 
   uni->tick = 0;
 }
@@ -163,21 +185,25 @@ setup_rx(int k) {
 
   /* conditioning */
   rx[k]->iqfix = newCorrectIQ(0.0, 1.0);
-  rx[k]->filt.coef = newFIR_Bandpass_COMPLEX(-4800.0,
-					     4800.0,
+  rx[k]->filt.lo = -4800.0;
+  rx[k]->filt.hi = 4800.0;
+  rx[k]->filt.taps = 0;
+  rx[k]->filt.coef = newFIR_Bandpass_COMPLEX(rx[k]->filt.lo,
+					     rx[k]->filt.hi,
 					     uni->rate.sample,
-					     rx[k]->len + 1);
-  rx[k]->filt.ovsv = newFiltOvSv(FIRcoef(rx[k]->filt.coef),
-				 FIRsize(rx[k]->filt.coef),
-				 uni->wisdom.bits);
-  normalize_vec_COMPLEX(rx[k]->filt.ovsv->zfvec, rx[k]->filt.ovsv->fftlen);
+					     RXTAPS(k));
+  rx[k]->filt.ovsv = newFiltOvSvPart(FIRcoef(rx[k]->filt.coef),
+				     FIRsize(rx[k]->filt.coef),
+				     rx[k]->len,
+				     uni->wisdom.bits);
+  normalize_OvSv(rx[k]->filt.ovsv);
 
   // hack for EQ
-  rx[k]->filt.save = newvec_COMPLEX(rx[k]->filt.ovsv->fftlen,
+  rx[k]->filt.save = newvec_COMPLEX(FiltOvSv_respsize(rx[k]->filt.ovsv),
 				    "RX filter cache");
   memcpy((char *) rx[k]->filt.save,
 	 (char *) rx[k]->filt.ovsv->zfvec,
-	 rx[k]->filt.ovsv->fftlen * sizeof(COMPLEX));
+	 FiltOvSv_respsize(rx[k]->filt.ovsv) * sizeof(COMPLEX));
 
   /* buffers */
   /* note we overload the internal filter buffers we just created */
@@ -189,6 +215,20 @@ setup_rx(int k) {
 			FiltOvSv_storepoint(rx[k]->filt.ovsv),
 			"init rx[k]->buf.o");
 
+  /* down to the audio rate after the filter, back up before the mix */
+  if (uni->rate.dec > 1) {
+    rx[k]->dec.down = newPolyPhaseFIR(rx[k]->buf.o, rx[k]->len,
+				      rx[k]->buf.o,
+				      1, uni->rate.dec, 0);
+    rx[k]->dec.buf = newCXB(rx[k]->len, 0, "rx interpolator output");
+    rx[k]->dec.up = newPolyPhaseFIR(rx[k]->buf.o, RXLEN(k),
+				    rx[k]->dec.buf,
+				    uni->rate.dec, 1, 0);
+  } else {
+    rx[k]->dec.down = rx[k]->dec.up = 0;
+    rx[k]->dec.buf = 0;
+  }
+
   /* conversion */
   rx[k]->osc.freq = -11025.0;
   rx[k]->osc.phase = 0.0;
@@ -201,13 +241,13 @@ setup_rx(int k) {
 
   rx[k]->dttspagc.gen = newDttSPAgc(1,	// mode kept around for control reasons alone
 				    CXBbase(rx[k]->buf.o),	// input buffer
-				    rx[k]->len,
+				    RXLEN(k),
 				    1.0,	// Target output 
 				    2.0,	// Attack time constant in ms
 				    500,	// Decay time constant in ms
 				    1.0,	// Slope
 				    500,	//Hangtime in ms
-				    uni->rate.sample,	// Sample rate
+				    RXRATE,	// Sample rate
 				    31622.8,	// Maximum gain as a multipler, linear not dB
 				    0.00001,	// Minimum gain as a multipler, linear not dB
 				    1.0,	// Set the current gain
@@ -215,34 +255,36 @@ setup_rx(int k) {
 
   rx[k]->dttspagc.flag = TRUE;
 
-  rx[k]->grapheq.gen = new_EQ(rx[k]->buf.o, uni->rate.sample, uni->wisdom.bits);
-  rx[k]->grapheq.flag = FALSE;
+  rx[k]->grapheq.gen = new_EQ(rx[k]->buf.o, RXRATE, uni->wisdom.bits);
+  rx[k]->grapheq.flag = rx[k]->grapheq.fused = FALSE;
 
   /* demods */
-  rx[k]->am.gen = newAMD(uni->rate.sample,	// REAL samprate
+  rx[k]->am.gen = newAMD(RXRATE,	// REAL samprate
 			 0.0,	// REAL f_initial
 			 -2000.0,	// REAL f_lobound,
 			 2000.0,	// REAL f_hibound,
 			 300.0,	// REAL f_bandwid,
-			 rx[k]->len,	// int size,
+			 RXLEN(k),	// int size,
 			 CXBbase(rx[k]->buf.o),	// COMPLEX *ivec,
 			 CXBbase(rx[k]->buf.o),	// COMPLEX *ovec,
 			 AMdet,	// AM Mode AMdet == rectifier,
 			 //         SAMdet == synchronous detector
 			 "AM detector blew");	// char *tag
-  rx[k]->fm.gen = newFMD(uni->rate.sample,	// REAL samprate
+  if (uni->rate.dec > 1)
+    strideAMD(rx[k]->am.gen, uni->rate.dec);
+  rx[k]->fm.gen = newFMD(RXRATE,	// REAL samprate
 			 0.0,	// REAL f_initial
 			 -6000.0,	// REAL f_lobound
 			 6000.0,	// REAL f_hibound
 			 5000.0,	// REAL f_bandwid
-			 rx[k]->len,	// int size,
+			 RXLEN(k),	// int size,
 			 CXBbase(rx[k]->buf.o),	// COMPLEX *ivec
 			 CXBbase(rx[k]->buf.o),	// COMPLEX *ovec
 			 "New FM Demod structure");	// char *error message;
 
   /* noise reduction */
   rx[k]->anf.gen = new_lmsr(rx[k]->buf.o,	// CXB signal,
-			    rx[k]->len,
+			    RXLEN(k),
 			    64,	// int delay,
 			    0.01,	// REAL adaptation_rate,
 			    0.00001,	// REAL leakage,
@@ -257,7 +299,7 @@ setup_rx(int k) {
   rx[k]->banf.flag = FALSE;
 
   rx[k]->anr.gen = new_lmsr(rx[k]->buf.o,	// CXB signal,
-			    rx[k]->len,
+			    RXLEN(k),
 			    64,	// int delay,
 			    0.01,	// REAL adaptation_rate,
 			    0.00001,	// REAL leakage,
@@ -283,14 +325,14 @@ setup_rx(int k) {
 				   700.0,	// freq
 				   5.0,	// ms rise
 				   5.0,	// ms fall
-				   rx[k]->len,
-				   uni->rate.sample);	// sample rate
+				   RXLEN(k),
+				   RXRATE);	// sample rate
 
   memset((char *) &rx[k]->squelch, 0, sizeof(rx[k]->squelch));
   rx[k]->squelch.thresh = -150.0;
   rx[k]->squelch.power = 0.0;
   rx[k]->squelch.flag = rx[k]->squelch.running = rx[k]->squelch.set = FALSE;
-  rx[k]->squelch.num = rx[k]->len - 48;
+  rx[k]->squelch.num = RXLEN(k) - 48;
 
   rx[k]->cpd.gen = newWSCompander(uni->cpdlen, 0.0, rx[k]->buf.o);
   rx[k]->cpd.flag = FALSE;
@@ -325,20 +367,25 @@ setup_tx(void) {
 
   /* conditioning */
   tx->iqfix = newCorrectIQ(0.0, 1.0);
-  tx->filt.coef = newFIR_Bandpass_COMPLEX(300.0,
-					  3000.0,
+  tx->filt.lo = 300.0;
+  tx->filt.hi = 3000.0;
+  tx->filt.taps = 0;
+  tx->filt.coef = newFIR_Bandpass_COMPLEX(tx->filt.lo,
+					  tx->filt.hi,
 					  uni->rate.sample,
-					  tx->len + 1);
-  tx->filt.ovsv = newFiltOvSv(FIRcoef(tx->filt.coef),
-			      FIRsize(tx->filt.coef),
-			      uni->wisdom.bits);
-  normalize_vec_COMPLEX(tx->filt.ovsv->zfvec, tx->filt.ovsv->fftlen);
+					  TXTAPS);
+  tx->filt.ovsv = newFiltOvSvPart(FIRcoef(tx->filt.coef),
+				  FIRsize(tx->filt.coef),
+				  tx->len,
+				  uni->wisdom.bits);
+  normalize_OvSv(tx->filt.ovsv);
 
   // hack for EQ
-  tx->filt.save = newvec_COMPLEX(tx->filt.ovsv->fftlen, "TX filter cache");
+  tx->filt.save = newvec_COMPLEX(FiltOvSv_respsize(tx->filt.ovsv),
+				 "TX filter cache");
   memcpy((char *) tx->filt.save,
 	 (char *) tx->filt.ovsv->zfvec,
-	 tx->filt.ovsv->fftlen * sizeof(COMPLEX));
+	 FiltOvSv_respsize(tx->filt.ovsv) * sizeof(COMPLEX));
 
   /* buffers */
   tx->buf.i = newCXB(tx->len,
@@ -487,6 +534,9 @@ destroy_workspace(void) {
     delAMD(rx[k]->am.gen);
     delFMD(rx[k]->fm.gen);
     delOSC(rx[k]->osc.gen);
+    delPolyPhaseFIR(rx[k]->dec.up);
+    delPolyPhaseFIR(rx[k]->dec.down);
+    delCXB(rx[k]->dec.buf);
     delvec_COMPLEX(rx[k]->filt.save);
     delFiltOvSv(rx[k]->filt.ovsv);
     delFIR_Bandpass_COMPLEX(rx[k]->filt.coef);
@@ -496,7 +546,648 @@ destroy_workspace(void) {
   }
 
   /* all */
-  finish_spectrum(&uni->spec);
+  delCXB(uni->multirx.buf);
+  delFiltCache(uni->filt.cache);
+  for (k = 0; k < MAXSPEC; k++)
+    finish_spectrum(&uni->spec[k]);
+}
+
+//========================================================================
+/* buffer length changes on the fly */
+
+// The pieces of rx/tx that depend on the buffer length,
+// built off to the side while the old ones keep running.
+// Everything else stays where it is; generators that only
+// point at buf.i/buf.o get their buffers retargeted.
+// After the swap this holds the old pieces, for freeing.
+
+typedef
+struct _resize_parts {
+  ComplexFIR coef;
+  FiltOvSv ovsv;
+  COMPLEX *save,
+          *circ,	// AGC/leveler lookahead
+          *down, *up;	// rx resampler histories
+  CXB osc, spot,
+      dec;		// rx interpolator output
+  RLB cg;		// speech processor gain curve
+} ResizeParts;
+
+PRIVATE struct {
+  int len;
+  ResizeParts rx[MAXRX], tx;
+  CXB in;
+} pend;
+
+REAL design_bandpass(REAL lo, REAL hi, int taps, REAL beta, BOOLEAN minph,
+		     ComplexFIR *coef, FiltOvSv ovsv, COMPLEX *z);
+PRIVATE void design_rx(int k, int taps, BOOLEAN fused,
+		      ComplexFIR *coef, FiltOvSv ovsv, COMPLEX *z);
+
+// ovsv sized for span taps, response left to the caller
+
+PRIVATE void
+build_filt(ResizeParts *p, int span, int len) {
+  p->ovsv = newFiltOvSvPart(0, span, len, uni->wisdom.bits);
+  p->save = newvec_COMPLEX(FiltOvSv_respsize(p->ovsv), "resize filter cache");
+}
+
+PRIVATE void
+keep_filt(ResizeParts *p) {
+  memcpy((char *) p->save,
+	 (char *) p->ovsv->zfvec,
+	 FiltOvSv_respsize(p->ovsv) * sizeof(COMPLEX));
+}
+
+// rx filter length with any folded-in EQ counted
+
+PRIVATE int
+rx_span(int taps, BOOLEAN fused) {
+  return (taps | 1) + (fused ? EQ_TAPS - 1 : 0);
+}
+
+PRIVATE void
+build_rx_filt(ResizeParts *p, int k, int taps, BOOLEAN fused, int len) {
+  build_filt(p, rx_span(taps, fused), len);
+  design_rx(k, taps, fused, &p->coef, p->ovsv, p->ovsv->zfvec);
+  keep_filt(p);
+}
+
+PRIVATE void
+build_tx_filt(ResizeParts *p, int taps, int len) {
+  build_filt(p, taps | 1, len);
+  design_bandpass(tx->filt.lo, tx->filt.hi, taps, TXBETA, FALSE,
+		  &p->coef, p->ovsv, p->ovsv->zfvec);
+  keep_filt(p);
+}
+
+// len at the input rate, alen where the AGC runs
+
+PRIVATE void
+build_parts(ResizeParts *p, int len, int alen) {
+  p->circ = newvec_COMPLEX(2 * alen, "resize agc buffer");
+  p->osc = newCXB(len, NULL, "resize oscillator buffer");
+}
+
+PRIVATE void
+free_parts(ResizeParts *p) {
+  delFIR_COMPLEX(p->coef);
+  delFiltOvSv(p->ovsv);
+  delvec_COMPLEX(p->save);
+  delvec_COMPLEX(p->circ);
+  delCXB(p->osc);
+  delCXB(p->spot);
+  delCXB(p->dec);
+  delvec_COMPLEX(p->down);
+  delvec_COMPLEX(p->up);
+  delRLB(p->cg);
+  memset((char *) p, 0, sizeof(ResizeParts));
+}
+
+// new filter in, its input history seeded from the old one
+
+PRIVATE void
+swap_filt(ComplexFIR *coef, FiltOvSv *ovsv, COMPLEX **save, ResizeParts *p) {
+  ComplexFIR c = *coef;
+  FiltOvSv f = *ovsv;
+  COMPLEX *s = *save;
+
+  carry_OvSv(p->ovsv, f);
+  *coef = p->coef, *ovsv = p->ovsv, *save = p->save;
+  p->coef = c, p->ovsv = f, p->save = s;
+}
+
+PRIVATE void
+retarget(CXB buf, COMPLEX *base, int len) {
+  CXBbase(buf) = base;
+  CXBsize(buf) = CXBwant(buf) = len;
+}
+
+// everything working in place on the filter buffers
+// follows them to wherever the filter now keeps them
+
+PRIVATE void
+rehome_rx(int k) {
+  struct _rx *r = rx[k];
+  int len = r->len, alen = RXLEN(k);
+
+  retarget(r->buf.i, FiltOvSv_fetchpoint(r->filt.ovsv), len);
+  retarget(r->buf.o, FiltOvSv_storepoint(r->filt.ovsv), len);
+  retarget(r->dttspagc.gen->buff, CXBbase(r->buf.o), alen);
+  retarget(r->am.gen->ibuf, CXBbase(r->buf.o), alen);
+  retarget(r->am.gen->obuf, CXBbase(r->buf.o), alen);
+  retarget(r->fm.gen->ibuf, CXBbase(r->buf.o), alen);
+  retarget(r->fm.gen->obuf, CXBbase(r->buf.o), alen);
+  retarget(r->cpd.gen->buff, CXBbase(r->buf.o), alen);
+
+  if (r->dec.down) {
+    r->dec.down->inp = r->dec.down->out = CXBbase(r->buf.o);
+    r->dec.up->inp = CXBbase(r->buf.o);
+    r->dec.up->out = CXBbase(r->dec.buf);
+  }
+}
+
+PRIVATE void
+rehome_tx(void) {
+  int len = tx->len;
+
+  retarget(tx->buf.i, FiltOvSv_fetchpoint(tx->filt.ovsv), len);
+  retarget(tx->buf.o, FiltOvSv_storepoint(tx->filt.ovsv), len);
+  retarget(tx->wvs.gen->buff, CXBbase(tx->buf.i), len);
+  retarget(tx->dcb.gen->buf, CXBbase(tx->buf.i), len);
+  retarget(tx->leveler.gen->buff, CXBbase(tx->buf.i), len);
+  retarget(tx->spr.gen->SpeechProcessorBuffer, CXBbase(tx->buf.i), len);
+  retarget(tx->cpd.gen->buff, CXBbase(tx->buf.o), len);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Build the pieces for a new buffer length 
+*
+* runs on its own thread while the DSP carries on;
+* caller keeps commands out so the filter settings hold still
+*
+* @param len 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+build_for_buflen(int len) {
+  int k;
+
+  pend.len = len;
+
+  for (k = 0; k < uni->multirx.nrx; k++) {
+    build_rx_filt(&pend.rx[k], k, FILTTAPS(rx[k]->filt, len),
+		  rx[k]->grapheq.fused, len);
+    build_parts(&pend.rx[k], len, len / uni->rate.dec);
+    pend.rx[k].spot = newCXB(len / uni->rate.dec, NULL, "resize spot buffer");
+    if (uni->rate.dec > 1) {
+      ResSt down = rx[k]->dec.down, up = rx[k]->dec.up;
+      pend.rx[k].dec = newCXB(len, NULL, "resize rx interpolator output");
+      pend.rx[k].down = newvec_COMPLEX(PolyPhaseFIR_histsize(down, len),
+				       "resize rx decimator past");
+      pend.rx[k].up = newvec_COMPLEX(PolyPhaseFIR_histsize(up, len / uni->rate.dec),
+				     "resize rx interpolator past");
+    }
+  }
+
+  build_tx_filt(&pend.tx, FILTTAPS(tx->filt, len), len);
+  build_parts(&pend.tx, len, len);
+  pend.tx.cg = newRLB(len + 1, NULL, "resize speech proc CG");
+
+  pend.in = newCXB(len, NULL, "shared rx input");
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Swap in the pieces for the new buffer length 
+*
+* DSP thread only, at a buffer boundary.
+* Settings, filter history, oscillator phase
+* and AGC gain and delay line all carry over.
+*
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+swap_for_buflen(void) {
+  int k, len = pend.len, alen = len / uni->rate.dec;
+
+  for (k = 0; k < uni->multirx.nrx; k++) {
+    struct _rx *r = rx[k];
+    ResizeParts *p = &pend.rx[k];
+
+    r->len = len;
+    if (r->dec.buf) {
+      CXB d = r->dec.buf;
+      r->dec.buf = p->dec, p->dec = d;
+      p->down = resizePolyPhaseFIR(r->dec.down, p->down, len);
+      p->up = resizePolyPhaseFIR(r->dec.up, p->up, alen);
+    }
+    swap_filt(&r->filt.coef, &r->filt.ovsv, &r->filt.save, p);
+    rehome_rx(k);
+
+    p->osc = (CXB) resizeOSC(r->osc.gen, p->osc, len);
+    p->circ = resizeDttSPAgc(r->dttspagc.gen, p->circ, CXBbase(r->buf.o), alen);
+
+    r->am.gen->size = r->fm.gen->size = alen;
+    r->anf.gen->signal_size = r->anr.gen->signal_size = alen;
+
+    p->spot = (CXB) resizeOSC(r->spot.gen->osc.gen, p->spot, alen);
+    r->spot.gen->size = alen;
+    retarget(r->spot.gen->buf, OSCCbase(r->spot.gen->osc.gen), alen);
+
+    r->squelch.num = alen - 48;
+  }
+
+  tx->len = len;
+  swap_filt(&tx->filt.coef, &tx->filt.ovsv, &tx->filt.save, &pend.tx);
+  rehome_tx();
+
+  pend.tx.osc = (CXB) resizeOSC(tx->osc.gen, pend.tx.osc, len);
+  pend.tx.circ = resizeDttSPAgc(tx->leveler.gen, pend.tx.circ, CXBbase(tx->buf.i), len);
+
+  {
+    RLB cg = tx->spr.gen->CG;
+    tx->spr.gen->CG = pend.tx.cg, pend.tx.cg = cg;
+    tx->spr.gen->size = len;
+  }
+
+  tx->squelch.num = len - 48;
+
+  {
+    CXB in = uni->multirx.buf;
+    uni->multirx.buf = pend.in, pend.in = in;
+  }
+
+  uni->buflen = len;
+  for (k = 0; k < MAXSPEC; k++)
+    uni->spec[k].buflen = len;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Free what the swap left behind 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+free_for_buflen(void) {
+  int k;
+  for (k = 0; k < uni->multirx.nrx; k++)
+    free_parts(&pend.rx[k]);
+  free_parts(&pend.tx);
+  delCXB(pend.in);
+  pend.in = 0;
+}
+
+//========================================================================
+/* filter length changes off the DSP thread */
+
+// A command that changes a filter's length builds the new filter
+// here first, on its own thread while it holds upd. Its thunk then
+// swaps it in on the DSP thread at a buffer boundary, which leaves
+// the old one here until the command is done and unstage_filt
+// frees it.
+
+PRIVATE ResizeParts stage;
+
+/* -------------------------------------------------------------------------- */
+/** @brief Build a new rx filter for the current settings 
+*
+* from the current lo/hi, taps and spec;
+* command thread, holding upd
+*
+* @param k 
+* @param fused with the graphic EQ folded in, as it will be
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+stage_rx_filt(int k, BOOLEAN fused) {
+  build_rx_filt(&stage, k, RXTAPS(k), fused, rx[k]->len);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Swap in the rx filter from stage_rx_filt 
+*
+* input history carried over. DSP thread only.
+*
+* @param k 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+swap_rx_filt(int k) {
+  swap_filt(&rx[k]->filt.coef, &rx[k]->filt.ovsv, &rx[k]->filt.save, &stage);
+  rehome_rx(k);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Build a new tx filter for the current settings 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+stage_tx_filt(void) {
+  build_tx_filt(&stage, TXTAPS, tx->len);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Swap in the tx filter from stage_tx_filt 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+swap_tx_filt(void) {
+  swap_filt(&tx->filt.coef, &tx->filt.ovsv, &tx->filt.save, &stage);
+  rehome_tx();
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Free whatever the last command left staged 
+*
+* the old filter after a swap, or the new one if it never went in
+*
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+unstage_filt(void) {
+  free_parts(&stage);
+}
+
+//========================================================================
+/* filter redesign off the DSP thread */
+
+// Commands just note which filters want redesigning from lo/hi
+// and poke the designer, which computes the new response into
+// the filter's spare and stages it. The filter swaps it in at
+// its next block. Commands and the designer both hold upd,
+// so neither sees the other's half-done work.
+
+PRIVATE struct {
+  BOOLEAN rx[MAXRX], tx;
+} want;
+
+/* -------------------------------------------------------------------------- */
+/** @brief Design a bandpass response for an OvSv filter 
+*
+* straight out of the shared cache if it's been done before
+* for the same edges, rate, length and filter geometry;
+* otherwise from scratch, and then cached
+*
+* @param lo 
+* @param hi 
+* @param taps 
+* @param beta Kaiser window shape, 0 for Blackman-Harris
+* @param minph minimum phase instead of linear
+* @param coef replaced with the new taps
+* @param ovsv 
+* @param z where the response goes
+* @return REAL normalization folded into the response
+*/
+/* ---------------------------------------------------------------------------- */
+REAL
+design_bandpass(REAL lo, REAL hi, int taps, REAL beta, BOOLEAN minph,
+		ComplexFIR *coef, FiltOvSv ovsv, COMPLEX *z) {
+  FiltCacheEntry e;
+  int window = beta > 0.0 ? KAISER_WINDOW : BLACKMANHARRIS_WINDOW;
+
+  taps |= 1;	// what newFIR_Bandpass_COMPLEX makes anyway
+  delFIR_COMPLEX(*coef);
+
+  if ((e = FiltCache_lookup(uni->filt.cache,
+			    lo, hi, uni->rate.sample,
+			    taps, window, beta, minph,
+			    ovsv))) {
+    *coef = newFIR_COMPLEX(taps, "cached bandpass");
+    memcpy((char *) FIRcoef(*coef), (char *) e->coef, taps * sizeof(COMPLEX));
+    FIRtype(*coef) = FIR_Bandpass;
+    memcpy((char *) z, (char *) e->resp,
+	   FiltOvSv_respsize(ovsv) * sizeof(COMPLEX));
+    return e->scale;
+
+  } else {
+    REAL scl;
+    if (beta > 0.0)
+      *coef = newFIR_Bandpass_Kaiser_COMPLEX(lo, hi, uni->rate.sample, taps, beta);
+    else
+      *coef = newFIR_Bandpass_COMPLEX(lo, hi, uni->rate.sample, taps);
+    if (minph)
+      FIR_MinPhase_COMPLEX(FIRcoef(*coef), taps);
+    loadresp_OvSv(ovsv, z, FIRcoef(*coef), taps, uni->wisdom.bits);
+    scl = normresp_OvSv(ovsv, z);
+    FiltCache_store(uni->filt.cache,
+		    lo, hi, uni->rate.sample,
+		    taps, window, beta, minph,
+		    ovsv, FIRcoef(*coef), z, scl);
+    return scl;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Fold the rx graphic EQ into a filter response 
+*
+* for a filter it's folded into. The bandpass taps, scaled
+* the way their own response was normalized, are convolved
+* with the EQ taps and the result replaces the response in z,
+* so one pass through the filter does the work of both.
+*
+* @param k 
+* @param coef the bandpass taps
+* @param scl normalization of the bandpass response
+* @param ovsv 
+* @param z 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+fuse_rx_eq(int k, ComplexFIR coef, REAL scl, FiltOvSv ovsv, COMPLEX *z) {
+  int i, j, nb = FIRsize(coef), n = nb + EQ_TAPS - 1;
+  COMPLEX *eq = rx[k]->grapheq.gen->coef, *h;
+
+  h = newvec_COMPLEX(n, "fused rx filter");
+  for (i = 0; i < nb; i++) {
+    COMPLEX b = Cscl(FIRtap(coef, i), scl);
+    for (j = 0; j < EQ_TAPS; j++)
+      h[i + j] = Cadd(h[i + j], Cmul(b, eq[j]));
+  }
+  // otherwise the EQ's own half-length delay comes back
+  if (rx[k]->filt.minph)
+    FIR_MinPhase_COMPLEX(h, n);
+  loadresp_OvSv(ovsv, z, h, n, uni->wisdom.bits);
+  delvec_COMPLEX(h);
+}
+
+PRIVATE void
+design_rx(int k, int taps, BOOLEAN fused,
+	  ComplexFIR *coef, FiltOvSv ovsv, COMPLEX *z) {
+  REAL scl = design_bandpass(rx[k]->filt.lo, rx[k]->filt.hi, taps, RXBETA(k),
+			     rx[k]->filt.minph, coef, ovsv, z);
+  if (fused)
+    fuse_rx_eq(k, *coef, scl, ovsv, z);
+}
+
+PRIVATE void
+redesign(REAL lo, REAL hi, int taps, REAL beta,
+	 ComplexFIR *coef, FiltOvSv ovsv, COMPLEX *save) {
+  COMPLEX *z = claim_OvSv(ovsv);
+
+  design_bandpass(lo, hi, taps, beta, FALSE, coef, ovsv, z);
+  memcpy((char *) save, (char *) z, FiltOvSv_respsize(ovsv) * sizeof(COMPLEX));
+  publish_OvSv(ovsv, uni->filt.fade);
+}
+
+PRIVATE void
+redesign_rx(int k) {
+  FiltOvSv ovsv = rx[k]->filt.ovsv;
+  COMPLEX *z = claim_OvSv(ovsv);
+
+  design_rx(k, RXTAPS(k), rx[k]->grapheq.fused, &rx[k]->filt.coef, ovsv, z);
+  memcpy((char *) rx[k]->filt.save, (char *) z,
+	 FiltOvSv_respsize(ovsv) * sizeof(COMPLEX));
+  publish_OvSv(ovsv, uni->filt.fade);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Design the rx filter in place 
+*
+* for when commands run synchronously
+*
+* @param k 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+load_rx_design(int k) {
+  design_rx(k, RXTAPS(k), rx[k]->grapheq.fused, &rx[k]->filt.coef,
+	    rx[k]->filt.ovsv, rx[k]->filt.ovsv->zfvec);
+  memcpy((char *) rx[k]->filt.save, (char *) rx[k]->filt.ovsv->zfvec,
+	 FiltOvSv_respsize(rx[k]->filt.ovsv) * sizeof(COMPLEX));
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Ask for an rx filter redesign 
+*
+* @param k 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+want_rx_design(int k) {
+  want.rx[k] = TRUE;
+  sem_post(top->sync.dsg.sem);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Ask for a tx filter redesign 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+want_tx_design(void) {
+  want.tx = TRUE;
+  sem_post(top->sync.dsg.sem);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Forget a pending rx filter redesign 
+*
+* for when the response gets set directly
+*
+* @param k 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+drop_rx_design(int k) {
+  want.rx[k] = FALSE;
+  cancel_OvSv(rx[k]->filt.ovsv);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Forget a pending tx filter redesign 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+drop_tx_design(void) {
+  want.tx = FALSE;
+  cancel_OvSv(tx->filt.ovsv);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Run the pending filter redesigns 
+*
+* designer thread, holding upd
+*
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+run_designs(void) {
+  int k;
+
+  for (k = 0; k < uni->multirx.nrx; k++)
+    if (want.rx[k]) {
+      want.rx[k] = FALSE;
+      redesign_rx(k);
+    }
+
+  if (want.tx) {
+    want.tx = FALSE;
+    redesign(tx->filt.lo, tx->filt.hi, TXTAPS, TXBETA,
+	     &tx->filt.coef, tx->filt.ovsv, tx->filt.save);
+  }
+}
+
+PRIVATE BOOLEAN
+eq_foldable(SDRMODE mode) {
+  // the EQ is designed for the audio rate, not the filter's
+  if (uni->rate.dec > 1)
+    return FALSE;
+  switch (mode) {
+  case LSB:
+  case USB:
+  case DSB:
+  case CWL:
+  case CWU:
+  case DIGU:
+  case DIGL:
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Make ready to refit the rx filter 
+*
+* In the linear modes the EQ rides along in the main filter
+* instead of running as a filter of its own after detection.
+* Folding it in or out changes the filter length; if the
+* coming settings will do that, build the new filter
+* now, off the DSP thread, for refit_rx_filter to swap in.
+* Command thread, holding upd.
+*
+* @param k 
+* @param flag EQ on, as it will be
+* @param mode as it will be
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+stage_rx_refit(int k, BOOLEAN flag, SDRMODE mode) {
+  BOOLEAN fused = flag && eq_foldable(mode);
+
+  if (fused != rx[k]->grapheq.fused)
+    stage_rx_filt(k, fused);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Bring the rx filter up to date with the graphic EQ 
+*
+* Folding it in or out swaps in the filter stage_rx_refit built;
+* new EQ settings alone are a redesign.
+* DSP thread only.
+*
+* @param k 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+refit_rx_filter(int k) {
+  BOOLEAN fused = rx[k]->grapheq.flag && eq_foldable(rx[k]->mode);
+
+  if (fused != rx[k]->grapheq.fused) {
+    rx[k]->grapheq.fused = fused;
+    drop_rx_design(k);
+    swap_rx_filt(k);
+  } else if (fused) {
+    if (top->defer)
+      want_rx_design(k);
+    else
+      load_rx_design(k);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -585,6 +1276,12 @@ CXBpeakpwr(CXB buff) {
   return maxpwr;
 }
 
+//========================================================================
+/* stage timing, one test apiece when off */
+
+#define RXLAP(k, s) do { if (uni->stats.flag) stats_lap(&uni->stats.rx[k], (s)); } while (0)
+#define TXLAP(s) do { if (uni->stats.flag) stats_lap(&uni->stats.tx, (s)); } while (0)
+
 //========================================================================
 /* all */
 
@@ -646,23 +1343,35 @@ do_rx_meter(int k, CXB buf, int tap) {
 * @param k 
 * @param buf 
 * @param type 
+* @param rate what buf is at, RXRATE past the decimator
 * @return void
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE void
-do_rx_spectrum(int k, CXB buf, int type) {
-  if (uni->spec.flag && k == uni->spec.rxk && type == uni->spec.type) {
-    if ((uni->spec.type == SPEC_POST_DET) && (!rx[k]->bin.flag)) {
+do_rx_spectrum(int k, CXB buf, int type, REAL rate) {
+  int j;
+  if (!uni->multispec.flag)
+    return;
+  for (j = 0; j < MAXSPEC; j++) {
+    SpecBlock *sb = &uni->spec[j];
+    if (k != sb->rxk || type != sb->type
+	|| tap_spectrum(sb) != SPEC_TAP_ON)
+      continue;
+    // spectrum thread takes the real transform of this one
+    sb->real = (sb->type == SPEC_POST_DET) && (!rx[k]->bin.flag);
+    if (sb->real) {
       int i;
       for (i = 0; i < CXBhave(rx[k]->buf.o); i++)
-	CXBdata(uni->spec.accum, uni->spec.fill + i) =
+	CXBdata(sb->accum, sb->fill + i) =
 	  Cmplx(CXBreal(rx[k]->buf.o, i) * M_SQRT2, 0.0);
     } else {
-      memcpy((char *) &CXBdata(uni->spec.accum, uni->spec.fill),
+      memcpy((char *) &CXBdata(sb->accum, sb->fill),
 	     (char *) CXBbase(buf),
 	     CXBhave(buf) * sizeof(COMPLEX));
     }
-    uni->spec.fill = (uni->spec.fill + CXBhave(buf)) & uni->spec.mask;
+    sb->fill = (sb->fill + CXBhave(buf)) & sb->mask;
+    sb->rate = rate;
+    sb->stream.fed += CXBhave(buf);
   }
 }
 
@@ -675,17 +1384,25 @@ do_rx_spectrum(int k, CXB buf, int type) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE void
 do_tx_spectrum(CXB buf) {
-  if (uni->spec.type == SPEC_PREMOD) {
-    int i;
-    for (i = 0; i < CXBhave(tx->buf.i); i++)
-      CXBdata(uni->spec.accum, uni->spec.fill + i) =
-	Cmplx(CXBreal(tx->buf.i, i), 0.0);
-  } else {
-    memcpy((char *) &CXBdata(uni->spec.accum, uni->spec.fill),
-	   (char *) CXBbase(buf),
-	   CXBhave(buf) * sizeof(COMPLEX));
+  int j;
+  for (j = 0; j < MAXSPEC; j++) {
+    SpecBlock *sb = &uni->spec[j];
+    if (tap_spectrum(sb) != SPEC_TAP_ON)
+      continue;
+    if ((sb->real = (sb->type == SPEC_PREMOD))) {
+      int i;
+      for (i = 0; i < CXBhave(tx->buf.i); i++)
+	CXBdata(sb->accum, sb->fill + i) =
+	  Cmplx(CXBreal(tx->buf.i, i), 0.0);
+    } else {
+      memcpy((char *) &CXBdata(sb->accum, sb->fill),
+	     (char *) CXBbase(buf),
+	     CXBhave(buf) * sizeof(COMPLEX));
+    }
+    sb->fill = (sb->fill + CXBhave(buf)) & sb->mask;
+    sb->rate = uni->rate.sample;
+    sb->stream.fed += CXBhave(buf);
   }
-  uni->spec.fill = (uni->spec.fill + CXBhave(buf)) & uni->spec.mask;
 }
 
 //========================================================================
@@ -838,25 +1555,42 @@ no_tx_squelch(void) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE void
 do_rx_pre(int k) {
-  int i, n = CXBhave(rx[k]->buf.i);
+  CXB in = uni->multirx.buf;
+  int i, n = CXBhave(in);
 
+  // private copy of the shared input, gain folded in;
+  // buf.i is the filter's own input area and gets worked on in place
   if (rx[k]->gain.i != 1.0)
-    CXBscl(rx[k]->buf.i, rx[k]->gain.i);
+    for (i = 0; i < n; i++)
+      CXBdata(rx[k]->buf.i, i) = Cscl(CXBdata(in, i), rx[k]->gain.i);
+  else
+    memcpy((char *) CXBbase(rx[k]->buf.i),
+	   (char *) CXBbase(in),
+	   n * sizeof(COMPLEX));
+  CXBhave(rx[k]->buf.i) = n;
+  RXLAP(k, RXSTAT_GAIN);
 
   // active signal is in buf.i
 
-  do_rx_spectrum(k, rx[k]->buf.i, SPEC_SEMI_RAW);
+  do_rx_spectrum(k, rx[k]->buf.i, SPEC_SEMI_RAW, uni->rate.sample);
+  RXLAP(k, RXSTAT_MISC);
 
-  if (rx[k]->nb.flag)
+  if (rx[k]->nb.flag) {
     noiseblanker(rx[k]->nb.gen);
-  if (rx[k]->nb_sdrom.flag)
+    RXLAP(k, RXSTAT_NB);
+  }
+  if (rx[k]->nb_sdrom.flag) {
     SDROMnoiseblanker(rx[k]->nb_sdrom.gen);
+    RXLAP(k, RXSTAT_SDROM);
+  }
 
   // metering for uncorrected values here
 
   do_rx_meter(k, rx[k]->buf.i, RXMETER_PRE_CONV);
+  RXLAP(k, RXSTAT_MISC);
 
   correctIQ(rx[k]->buf.i, rx[k]->iqfix);
+  RXLAP(k, RXSTAT_IQ);
 
   /* 2nd IF conversion happens here */
 
@@ -865,11 +1599,13 @@ do_rx_pre(int k) {
     for (i = 0; i < n; i++)
       CXBdata(rx[k]->buf.i, i) = Cmul(CXBdata(rx[k]->buf.i, i),
 				      OSCCdata(rx[k]->osc.gen, i));
+    RXLAP(k, RXSTAT_OSC);
   }
 
   // filtering, metering, spectrum, squelch, & AGC
 
-  do_rx_spectrum(k, rx[k]->buf.i, SPEC_PRE_FILT);
+  do_rx_spectrum(k, rx[k]->buf.i, SPEC_PRE_FILT, uni->rate.sample);
+  RXLAP(k, RXSTAT_MISC);
 
 #if 0
   fprintf(stdout, " %9.6f", CXBnorm(rx[k]->buf.i));
@@ -884,6 +1620,8 @@ do_rx_pre(int k) {
 	   CXBbase(rx[k]->buf.i),
 	   sizeof(COMPLEX) * CXBhave(rx[k]->buf.i));
 
+  RXLAP(k, RXSTAT_FILT);
+
   // active signal is now in buf.o
 
   CXBhave(rx[k]->buf.o) = CXBhave(rx[k]->buf.i);
@@ -895,18 +1633,32 @@ do_rx_pre(int k) {
 #endif
 
   do_rx_meter(k, rx[k]->buf.o, RXMETER_POST_FILT);
-  do_rx_spectrum(k, rx[k]->buf.o, SPEC_POST_FILT);
+  do_rx_spectrum(k, rx[k]->buf.o, SPEC_POST_FILT, uni->rate.sample);
+  RXLAP(k, RXSTAT_MISC);
 
-  if (rx[k]->cpd.flag)
+  // everything from here to the mix runs at the audio rate
+
+  if (rx[k]->dec.down) {
+    PolyPhaseFIR(rx[k]->dec.down);
+    CXBhave(rx[k]->buf.o) = rx[k]->dec.down->nout;
+    RXLAP(k, RXSTAT_RSMP);
+  }
+
+  if (rx[k]->cpd.flag) {
     WSCompand(rx[k]->cpd.gen);
+    RXLAP(k, RXSTAT_CPD);
+  }
 
   should_do_rx_squelch(k);
+  RXLAP(k, RXSTAT_SQL);
 
   CXBhave(rx[k]->dttspagc.gen->buff) = CXBhave(rx[k]->buf.o);
   DttSPAgc(rx[k]->dttspagc.gen, rx[k]->tick);
+  RXLAP(k, RXSTAT_AGC);
 
   do_rx_meter(k, rx[k]->buf.o, RXMETER_POST_AGC);
-  do_rx_spectrum(k, rx[k]->buf.o, SPEC_POST_AGC);
+  do_rx_spectrum(k, rx[k]->buf.o, SPEC_POST_AGC, RXRATE);
+  RXLAP(k, RXSTAT_MISC);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -934,10 +1686,15 @@ do_rx_post(int k) {
     }
   }
 
-  if (rx[k]->grapheq.flag)
+  RXLAP(k, RXSTAT_SQL);
+
+  if (rx[k]->grapheq.flag && !rx[k]->grapheq.fused) {
     graphiceq(rx[k]->grapheq.gen);
+    RXLAP(k, RXSTAT_EQ);
+  }
 
-  do_rx_spectrum(k, rx[k]->buf.o, SPEC_POST_DET);
+  do_rx_spectrum(k, rx[k]->buf.o, SPEC_POST_DET, RXRATE);
+  RXLAP(k, RXSTAT_MISC);
 
   // apply individual rx gain
 
@@ -951,6 +1708,18 @@ do_rx_post(int k) {
     for (i = 0; i < n; i++)
       CXBdata(rx[k]->buf.o, i) = Cscl(rx[k]->azim,
 				      M_SQRT2 * CXBreal(rx[k]->buf.o, i));
+  RXLAP(k, RXSTAT_OUT);
+
+  // back up to the input rate for the mix
+
+  if (rx[k]->dec.up) {
+    PolyPhaseFIR(rx[k]->dec.up);
+    memcpy((char *) CXBbase(rx[k]->buf.o),
+	   (char *) CXBbase(rx[k]->dec.buf),
+	   rx[k]->dec.up->nout * sizeof(COMPLEX));
+    CXBhave(rx[k]->buf.o) = rx[k]->dec.up->nout;
+    RXLAP(k, RXSTAT_RSMP);
+  }
 
   // active signal now in buf.o
 }
@@ -968,25 +1737,34 @@ PRIVATE void
 do_rx_SBCW(int k) {
 
   if (rx[k]->bin.flag) {
-    if ((rx[k]->banr.flag) && (rx[k]->anr.flag))
+    if ((rx[k]->banr.flag) && (rx[k]->anr.flag)) {
       blms_adapt(rx[k]->banr.gen);
-    if ((rx[k]->banf.flag) && (rx[k]->anf.flag))
+      RXLAP(k, RXSTAT_NR);
+    }
+    if ((rx[k]->banf.flag) && (rx[k]->anf.flag)) {
       blms_adapt(rx[k]->banf.gen);
+      RXLAP(k, RXSTAT_ANF);
+    }
 
   } else {
     int i;
-    if (rx[k]->anr.flag)
+    if (rx[k]->anr.flag) {
       if (rx[k]->banr.flag)
 	blms_adapt(rx[k]->banr.gen);
       else
 	lmsr_adapt(rx[k]->anr.gen);
-    if (rx[k]->anf.flag)
+      RXLAP(k, RXSTAT_NR);
+    }
+    if (rx[k]->anf.flag) {
       if (rx[k]->banf.flag)
 	blms_adapt(rx[k]->banf.gen);
       else
 	lmsr_adapt(rx[k]->anf.gen);
+      RXLAP(k, RXSTAT_ANF);
+    }
     for (i = 0; i < CXBhave(rx[k]->buf.o); i++)
       CXBimag(rx[k]->buf.o, i) = CXBreal(rx[k]->buf.o, i);
+    RXLAP(k, RXSTAT_DEMOD);
   }
 }
 
@@ -1000,11 +1778,14 @@ do_rx_SBCW(int k) {
 PRIVATE void
 do_rx_AM(int k) {
   AMDemod(rx[k]->am.gen);
-  if (rx[k]->anf.flag)
+  RXLAP(k, RXSTAT_DEMOD);
+  if (rx[k]->anf.flag) {
     if (!rx[k]->banf.flag)
       lmsr_adapt(rx[k]->anf.gen);
     else
       blms_adapt(rx[k]->banf.gen);
+    RXLAP(k, RXSTAT_ANF);
+  }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1015,7 +1796,10 @@ do_rx_AM(int k) {
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE void
-do_rx_FM(int k) { FMDemod(rx[k]->fm.gen); }
+do_rx_FM(int k) {
+  FMDemod(rx[k]->fm.gen);
+  RXLAP(k, RXSTAT_DEMOD);
+}
 
 /* -------------------------------------------------------------------------- */
 /** @brief private do_rx_DRM
@@ -1062,6 +1846,8 @@ do_rx_NIL(int k) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE void
 do_rx(int k) {
+  if (uni->stats.flag)
+    stats_start(&uni->stats.rx[k]);
   do_rx_pre(k);
   switch (rx[k]->mode) {
   case DIGU:
@@ -1079,6 +1865,8 @@ do_rx(int k) {
   default:  do_rx_SPEC(k); break;
   }
   do_rx_post(k);
+  if (uni->stats.flag)
+    stats_stop(&uni->stats.rx[k], RXSTAT_TOTAL);
 }
 
 //==============================================================
@@ -1173,44 +1961,63 @@ do_tx_pre(void) {
   for (i = 0; i < CXBhave(tx->buf.i); i++) 
     CXBreal(tx->buf.i, i) = CXBimag(tx->buf.i, i),
     CXBimag(tx->buf.i, i) = 0.0;
+  TXLAP(TXSTAT_GAIN);
 
   // active sig in buf.i, now real part
 
   /***/
   // experimental placement for pre-distortion/linearization
 
-  if (tx->wvs.flag)
+  if (tx->wvs.flag) {
     WaveShape(tx->wvs.gen);
+    TXLAP(TXSTAT_WVS);
+  }
   do_tx_meter(tx->buf.i, TX_WAVS);
+  TXLAP(TXSTAT_MISC);
 
   /***/
 
-  if (tx->dcb.flag)
+  if (tx->dcb.flag) {
     DCBlock(tx->dcb.gen);
+    TXLAP(TXSTAT_DCB);
+  }
 
   do_tx_meter(tx->buf.i, TX_MIC);
+  TXLAP(TXSTAT_MISC);
 
-  if (should_do_tx_squelch())
+  if (should_do_tx_squelch()) {
     do_tx_squelch();
-  else {
+    TXLAP(TXSTAT_SQL);
+  } else {
     if (!tx->squelch.set)
       no_tx_squelch();
+    TXLAP(TXSTAT_SQL);
     if ((tx->mode != DIGU) && (tx->mode != DIGL)) {
-      if (tx->grapheq.flag)
+      if (tx->grapheq.flag) {
 	graphiceq(tx->grapheq.gen);
+	TXLAP(TXSTAT_EQ);
+      }
       do_tx_meter(tx->buf.i, TX_EQtap);
-      if (tx->leveler.flag)
+      TXLAP(TXSTAT_MISC);
+      if (tx->leveler.flag) {
 	DttSPAgc(tx->leveler.gen, tx->tick);
+	TXLAP(TXSTAT_LVL);
+      }
       do_tx_meter(tx->buf.i, TX_LEVELER);
-      if (tx->spr.flag)
+      TXLAP(TXSTAT_MISC);
+      if (tx->spr.flag) {
 	SpeechProcessor(tx->spr.gen);
+	TXLAP(TXSTAT_SPR);
+      }
       do_tx_meter(tx->buf.i, TX_COMP);
+      TXLAP(TXSTAT_MISC);
     } else {
       do_tx_meter(tx->buf.i, TX_EQtap);
       do_tx_meter(tx->buf.i, TX_LEVELER);
       do_tx_meter(tx->buf.i, TX_LVL_G);
       do_tx_meter(tx->buf.i, TX_COMP);
       do_tx_meter(tx->buf.i, TX_CPDR);
+      TXLAP(TXSTAT_MISC);
     }
   }
 }
@@ -1230,15 +2037,19 @@ do_tx_post(void) {
   if (tx->tick == 0)
     reset_OvSv(tx->filt.ovsv);
   filter_OvSv(tx->filt.ovsv);
+  TXLAP(TXSTAT_FILT);
 
   // active signal now in buf.o
 
-  if (tx->cpd.flag)
+  if (tx->cpd.flag) {
     WSCompand(tx->cpd.gen);
+    TXLAP(TXSTAT_CPD);
+  }
   do_tx_meter(tx->buf.o, TX_CPDR);
   
-  if (uni->spec.flag)
+  if (uni->multispec.flag)
     do_tx_spectrum(tx->buf.o);
+  TXLAP(TXSTAT_MISC);
 	    
   if (tx->osc.gen->Frequency != 0.0) {
     int i;
@@ -1247,14 +2058,17 @@ do_tx_post(void) {
       CXBdata(tx->buf.o, i) = Cmul(CXBdata(tx->buf.o, i),
 				   OSCCdata(tx->osc.gen, i));
     }
+    TXLAP(TXSTAT_OSC);
   }
 
   correctIQ(tx->buf.o, tx->iqfix);
+  TXLAP(TXSTAT_IQ);
 
   if (tx->gain.o != 1.0)
     CXBscl(tx->buf.o, tx->gain.o);
 
   do_tx_meter(tx->buf.o, TX_PWR);
+  TXLAP(TXSTAT_OUT);
 }
 
 
@@ -1322,6 +2136,8 @@ do_tx_NIL(void) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE void
 do_tx(void) {
+  if (uni->stats.flag)
+    stats_start(&uni->stats.tx);
   do_tx_pre();
   switch (tx->mode) {
   case USB:
@@ -1338,52 +2154,141 @@ do_tx(void) {
   case SPEC:
   default:   do_tx_NIL();  break;
   }
+  TXLAP(TXSTAT_MOD);
   do_tx_post();
+  if (uni->stats.flag)
+    stats_stop(&uni->stats.tx, TXSTAT_TOTAL);
 }
 
 //========================================================================
 
+/* -------------------------------------------------------------------------- */
+/** @brief rx_worker_thread 
+* 
+* one per receiver when running in parallel;
+*   waits for the go-ahead from process_samples,
+*   runs receiver k against its own state,
+*   then reports back
+*
+* @param arg receiver number k
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+rx_worker_thread(void *arg) {
+  int k = (int) (long) arg;
+
+  for (;;) {
+    sem_wait(top->sync.rxw[k].sem);
+    do_rx(k), rx[k]->tick++;
+    sem_post(top->sync.rxd.sem);
+  }
+}
+
+// how far behind the AGC's look-ahead puts its output,
+// if it's on and being handed anything to work on
+
+PRIVATE int
+agc_delay(DTTSPAGC a) {
+  if (a->mode == agcOFF || CXBhave(a->buff) == 0)
+    return 0;
+  return (a->sndx - a->indx) & a->mask;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief chain_delay 
+* 
+* how far output lags input as things are set up now,
+* in frames at the sample rate: half of each filter on
+* the way through, the rx decimator both ways, and the
+* AGC's look-ahead. Exact for linear phase, generous for
+* minimum phase; in rx, the slowest of the active receivers
+*
+* @return int
+*/
+/* ---------------------------------------------------------------------------- */
+int
+chain_delay(void) {
+  int k, d = 0;
+
+  if (uni->mode.trx == TX) {
+    d = (TXTAPS | 1) / 2;
+    if (tx->grapheq.flag)
+      d += EQ_TAPS / 2;
+    if (tx->leveler.flag)
+      d += agc_delay(tx->leveler.gen);
+    return d;
+  }
+
+  for (k = 0; k < uni->multirx.nrx; k++)
+    if (uni->multirx.act[k]) {
+      int e = rx_span(RXTAPS(k), rx[k]->grapheq.fused) / 2;
+      if (rx[k]->grapheq.flag && !rx[k]->grapheq.fused)
+	e += EQ_TAPS / 2 * uni->rate.dec;
+      if (rx[k]->dttspagc.flag)
+	e += agc_delay(rx[k]->dttspagc.gen) * uni->rate.dec;
+      if (rx[k]->dec.down)
+	e += rx[k]->dec.down->nflt / 2 + rx[k]->dec.up->nflt / 2;
+      d = max(d, e);
+    }
+  return d;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief process_samples 
 * 
 * overall buffer processing;
 *   come here when there are buffers to work on 
 
-* @param bufl 
-* @param bufr 
+*   input and output may be the same buffers
+
+* @param inl 
+* @param inr 
+* @param outl 
+* @param outr 
 * @param n 
 * @return void
 */
 /* ---------------------------------------------------------------------------- */
 void
-process_samples(float *bufl, float *bufr, int n) {
+process_samples(float *inl, float *inr, float *outl, float *outr, int n) {
   int i, k;
 
   switch (uni->mode.trx) {
 
   case RX:
 
-    // make copies of the input for all receivers
-    for (k = 0; k < uni->multirx.nrx; k++)
-      if (uni->multirx.act[k]) {
-	for (i = 0; i < n; i++)
-	  CXBimag(rx[k]->buf.i, i) = bufl[i],
-	  CXBreal(rx[k]->buf.i, i) = bufr[i];
-	CXBhave(rx[k]->buf.i) = n;
-      }
+    // deinterleave once, receivers pick it up from here
+    for (i = 0; i < n; i++)
+      CXBimag(uni->multirx.buf, i) = inl[i],
+      CXBreal(uni->multirx.buf, i) = inr[i];
+    CXBhave(uni->multirx.buf) = n;
 
     // prepare buffers for mixing
-    memset((char *) bufl, 0, n * sizeof(float));
-    memset((char *) bufr, 0, n * sizeof(float));
+    memset((char *) outl, 0, n * sizeof(float));
+    memset((char *) outr, 0, n * sizeof(float));
+
+    // run all receivers,
+    // on the worker pool if there's more than one
+    if (uni->multirx.par && uni->multirx.nac > 1) {
+      int nrun = 0;
+      for (k = 0; k < uni->multirx.nrx; k++)
+	if (uni->multirx.act[k])
+	  sem_post(top->sync.rxw[k].sem), nrun++;
+      while (nrun-- > 0)
+	sem_wait(top->sync.rxd.sem);
+    } else {
+      for (k = 0; k < uni->multirx.nrx; k++)
+	if (uni->multirx.act[k])
+	  do_rx(k), rx[k]->tick++;
+    }
 
-    // run all receivers
+    // mix, always in receiver order
     for (k = 0; k < uni->multirx.nrx; k++)
       if (uni->multirx.act[k]) {
-	do_rx(k), rx[k]->tick++;
-	// mix
 	for (i = 0; i < n; i++)
-	  bufl[i] += CXBimag(rx[k]->buf.o, i),
-	  bufr[i] += CXBreal(rx[k]->buf.o, i);
+	  outl[i] += CXBimag(rx[k]->buf.o, i),
+	  outr[i] += CXBreal(rx[k]->buf.o, i);
 	CXBhave(rx[k]->buf.o) = n;
       }
 
@@ -1392,20 +2297,33 @@ process_samples(float *bufl, float *bufr, int n) {
   case TX:
 
     for (i = 0; i < n; i++)
-      CXBimag(tx->buf.i, i) = bufl[i],
-      CXBreal(tx->buf.i, i) = bufr[i];
+      CXBimag(tx->buf.i, i) = inl[i],
+      CXBreal(tx->buf.i, i) = inr[i];
     CXBhave(tx->buf.i) = n;
     tx->norm = CXBpeak(tx->buf.i);
 
     do_tx(), tx->tick++;
 
     for (i = 0; i < n; i++)
-      bufl[i] = CXBimag(tx->buf.o, i),
-      bufr[i] = CXBreal(tx->buf.o, i);
+      outl[i] = CXBimag(tx->buf.o, i),
+      outr[i] = CXBreal(tx->buf.o, i);
     CXBhave(tx->buf.o) = n;
 
     break;
   }
 
+  // streamed spectrum frames, paced by the samples each tap took,
+  // at its own rate
+  if (uni->multispec.flag)
+    for (k = 0; k < MAXSPEC; k++) {
+      SpecBlock *sb = &uni->spec[k];
+      if (tap_spectrum(sb) == SPEC_TAP_ON
+	  && tick_spectrum(sb, sb->stream.fed, sb->rate)) {
+	snap_spectrum(sb, sb->stream.label, uni->tick);
+	sem_post(top->sync.pws.sem);
+      }
+      sb->stream.fed = 0;
+    }
+
   uni->tick++;
 }
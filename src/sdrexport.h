@@ -46,6 +46,7 @@ Bridgewater, NJ 08807
 #include <fftw3.h>
 #include <ovsv.h>
 #include <filter.h>
+#include <filtcache.h>
 #include <oscillator.h>
 #include <dttspagc.h>
 #include <am_demod.h>
@@ -59,11 +60,16 @@ Bridgewater, NJ 08807
 #include <meter.h>
 #include <spectrum.h>
 #include <resample.h>
+#include <stats.h>
 //------------------------------------------------------------------------
 // max no. simultaneous receivers
 #ifndef MAXRX
 #define MAXRX (4)
 #endif
+// max no. spectrum taps
+#ifndef MAXSPEC
+#define MAXSPEC (4)
+#endif
 //------------------------------------------------------------------------
 /* modulation types, modes */
 
@@ -74,6 +80,7 @@ extern
 struct _uni {
   struct {
     REAL sample;
+    int dec;		// rx runs at sample/dec after its filter
   } rate;
   int buflen;
 
@@ -83,7 +90,8 @@ struct _uni {
   } mode;
 
   METERBlock meter;
-  SpecBlock spec;
+  SpecBlock spec[MAXSPEC];
+  StatsBlock stats;
 
   struct {
     BOOLEAN flag;
@@ -98,10 +106,21 @@ struct _uni {
   } wisdom;
 
   struct {
-    BOOLEAN act[MAXRX];
+    BOOLEAN act[MAXRX], par;
     int lis, nac, nrx;
+    CXB buf;	// deinterleaved input, read-only to receivers
   } multirx;
 
+  struct {
+    BOOLEAN flag;	// spectrum thread running
+    int sel;	// tap spectrum commands go to
+  } multispec;
+
+  struct {
+    BOOLEAN fade;	// crossfade one block when a redesigned filter goes in
+    FiltCache cache;	// designs shared by all rx and tx
+  } filt;
+
   int cpdlen;
   long tick;
 
@@ -129,11 +148,19 @@ struct _rx {
 
   struct {
     REAL lo, hi;
+    int taps;		// 0: follow the buffer length
+    FIRSpecDesc spec;	// if set, overrides taps: Kaiser, just long enough
+    BOOLEAN minph;	// minimum phase, for less delay
     ComplexFIR coef;
     FiltOvSv ovsv;
     COMPLEX *save;
   } filt;
 
+  struct {
+    ResSt down, up;	// only when uni->rate.dec > 1
+    CXB buf;		// up's output
+  } dec;
+
   struct {
     REAL thresh;
     NB gen;
@@ -187,7 +214,8 @@ struct _rx {
 
   struct {
     EQ gen;
-    BOOLEAN flag;
+    BOOLEAN flag,
+            fused;	// folded into filt, not run on its own
     struct {
       int size;
       REAL pre, gain[10];
@@ -236,6 +264,8 @@ struct _tx {
 
   struct {
     REAL lo, hi;
+    int taps;		// 0: follow the buffer length
+    FIRSpecDesc spec;	// if set, overrides taps: Kaiser, just long enough
     ComplexFIR coef;
     FiltOvSv ovsv;
     COMPLEX *save;
@@ -303,6 +333,26 @@ struct _tx {
 
 } *tx;
 
+// filter length: what the spec needs, explicit,
+// or tied to the buffer length
+#define FILTTAPS(f, len) ((f).spec.size > 0 ? (f).spec.size \
+			  : (f).taps > 0 ? (f).taps : (len) + 1)
+#define RXTAPS(k) FILTTAPS(rx[k]->filt, rx[k]->len)
+#define TXTAPS FILTTAPS(tx->filt, tx->len)
+
+// window shape to go with it, 0 for the usual Blackman-Harris
+#define RXBETA(k) (rx[k]->filt.spec.beta)
+#define TXBETA (tx->filt.spec.beta)
+
+// rate and block length from the rx filter on
+#define RXRATE (uni->rate.sample / uni->rate.dec)
+#define RXLEN(k) (rx[k]->len / uni->rate.dec)
+
+// limits on decimation: the graphic EQ works 256 at a time
+// and reaches out to 6 kHz
+#define MINRXLEN (256)
+#define MINRXRATE (12000.0)
+
 //------------------------------------------------------------------------
 
 typedef
@@ -322,7 +372,8 @@ struct _top {
 
   struct timeval start_tv;
 
-  BOOLEAN running, verbose;
+  BOOLEAN running, verbose,
+          defer;	// commands run by the DSP thread at buffer boundaries
   RUNMODE state;
 
   // audio io
@@ -330,7 +381,8 @@ struct _top {
   struct {
     struct {
       float *l, *r;
-    } buf;
+    } buf,
+      in, out;	// point straight into the rings when they don't wrap
     struct {
       unsigned int frames, bytes;
     } size;
@@ -380,6 +432,28 @@ struct _top {
       } i, o;
     } ring;
 
+    // rate conversion at the rings, when jack doesn't run at ours;
+    // l and r ride together as the two halves of a complex sample
+    struct {
+      BOOLEAN on;
+      int rate;		// jack's
+      ResSt i, o;
+      CXB in,		// jack rate, off the input ring
+	  fifo,		// dsp rate, waiting to make up a block
+	  blk,		// dsp rate, one block for the output side
+	  out;		// jack rate, bound for the output ring
+      int have;		// samples in fifo
+    } cvt;
+
+    // trouble accounting, see getAudioStats
+    struct {
+      unsigned long xrun, ovfl, unfl, late, pass;
+      struct {
+	size_t i, o;
+      } hwm;
+      double worst;	// longest pass, usec
+    } stat;
+
   } snds;
 
   // update io
@@ -387,14 +461,14 @@ struct _top {
   struct {
     struct {
       pthread_t id;
-    } mtr, pws, trx, upd;
+    } bld, dsg, mtr, pws, trx, upd, rxw[MAXRX];
   } thrd;
 
   struct {
     struct {
       sem_t *sem;
       char name[512];
-    } buf, mtr, pws, upd;
+    } ack, bld, buf, dsg, mtr, pws, upd, rxd, rxw[MAXRX];
   } sync;
 
   // TRX switching
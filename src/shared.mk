@@ -13,6 +13,7 @@ OBJ =	am_demod.o\
 	dttspagc.o\
 	fastrig.o\
 	filter.o\
+	filtcache.o\
 	graphiceq.o\
 	isoband.o\
 	fm_demod.o\
@@ -28,6 +29,7 @@ OBJ =	am_demod.o\
 	spectrum.o\
 	speechproc.o\
 	splitfields.o\
+	stats.o\
 	spottone.o\
 	thunk.o\
 	window.o\
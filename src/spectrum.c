@@ -36,11 +36,75 @@ Bridgewater, NJ 08807
 */
 
 #include <spectrum.h>
+#include <filter.h>
+
+/* -------------------------------------------------------------------------- */
+/** @brief Get a snapshot to fill 
+* 
+* DSP thread; never waits. A snapshot published but not
+* picked up yet is taken back and overwritten, so there's
+* only ever one waiting, and the newest.
+*
+* @param sb 
+* @return SpecSnap *
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE SpecSnap *
+claim_snap(SpecBlock *sb) {
+  for (;;) {
+    int k;
+    for (k = 0; k < 2; k++)
+      if (__sync_bool_compare_and_swap(&sb->snap[k].stage, SPEC_SNAP_READY, SPEC_SNAP_FILL))
+	return &sb->snap[k];
+    // the spectrum thread has at most one of them
+    for (k = 0; k < 2; k++)
+      if (__sync_bool_compare_and_swap(&sb->snap[k].stage, SPEC_SNAP_IDLE, SPEC_SNAP_FILL))
+	return &sb->snap[k];
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Copy out the most recent signal, oldest first 
+* 
+* @param sb 
+* @param ss from claim_snap, published when done
+* @param n how much
+* @param label 
+* @param stamp 
+* @param last SPEC_LAST_FREQ or SPEC_LAST_TIME
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+fill_snap(SpecBlock *sb, SpecSnap *ss, int n, int label, int stamp, int last) {
+  int j = (sb->fill + sb->mask + 1 - n) & sb->mask,
+      m = min(n, sb->mask + 1 - j);
+
+  memcpy((char *) CXBbase(ss->buf),
+	 (char *) &CXBdata(sb->accum, j),
+	 m * sizeof(COMPLEX));
+  memcpy((char *) &CXBdata(ss->buf, m),
+	 (char *) CXBbase(sb->accum),
+	 (n - m) * sizeof(COMPLEX));
+  CXBhave(ss->buf) = n;
+
+  ss->label = label;
+  ss->stamp = stamp;
+  ss->last = last;
+  ss->scale = sb->scale;
+  ss->polyphase = sb->polyphase;
+  ss->real = sb->real;
+  ss->wintype = sb->wintype;
+  ss->view = sb->view;
+
+  __sync_bool_compare_and_swap(&ss->stage, SPEC_SNAP_FILL, SPEC_SNAP_READY);
+}
 
 /* -------------------------------------------------------------------------- */
 /** @brief Function to take a stapshot of the spectrum 
 * 
-* snapshot of current signal
+* snapshot of current signal. Just a copy; windowing
+* and the transform are left to claim_spectrum's caller.
 *
 * @param sb 
 * @param label 
@@ -50,100 +114,427 @@ Bridgewater, NJ 08807
 /* ---------------------------------------------------------------------------- */
 void
 snap_spectrum(SpecBlock *sb, int label, int stamp) {
-  int i, j;
+  fill_snap(sb, claim_snap(sb), sb->mask + 1, label, stamp, SPEC_LAST_FREQ);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief cwFunction to take a snapshot of the oscilloscope 
+* 
+* @param sb 
+* @param label 
+* @param stamp 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+snap_scope(SpecBlock *sb, int label, int stamp) {
+  fill_snap(sb, claim_snap(sb), sb->size, label, stamp, SPEC_LAST_TIME);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Is a streamed frame due? 
+* 
+* DSP thread, once a buffer. Paced off the samples going
+* through, so frames come evenly however the buffers are
+* timed; faster than the buffers go, it's one every buffer.
+*
+* @param sb 
+* @param n samples the tap took in this buffer
+* @param rate sample rate they're at, the tap's own
+* @return BOOLEAN
+*/
+/* ---------------------------------------------------------------------------- */
+BOOLEAN
+tick_spectrum(SpecBlock *sb, int n, REAL rate) {
+  if (sb->stream.fps <= 0.0)
+    return FALSE;
+  sb->stream.due += n * sb->stream.fps;
+  if (sb->stream.due < rate)
+    return FALSE;
+  sb->stream.due = (REAL) fmod(sb->stream.due, rate);
+  return TRUE;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Pick up the newest snapshot 
+* 
+* spectrum thread. Hand it back with release_spectrum.
+*
+* @param sb 
+* @return SpecSnap *, 0 if there's nothing new
+*/
+/* ---------------------------------------------------------------------------- */
+SpecSnap *
+claim_spectrum(SpecBlock *sb) {
+  int k;
+  for (k = 0; k < 2; k++)
+    if (__sync_bool_compare_and_swap(&sb->snap[k].stage, SPEC_SNAP_READY, SPEC_SNAP_BUSY))
+      return &sb->snap[k];
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Done with a snapshot 
+* 
+* @param sb 
+* @param ss 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+release_spectrum(SpecBlock *sb, SpecSnap *ss) {
+  __sync_bool_compare_and_swap(&ss->stage, SPEC_SNAP_BUSY, SPEC_SNAP_IDLE);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Bring the window up to date with a snapshot 
+* 
+* spectrum thread; the window is only ever rebuilt here
+*
+* @param sb 
+* @param ss 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+fit_window(SpecBlock *sb, SpecSnap *ss) {
+  int i, n = 8 * sb->size;
+
+  if (ss->polyphase == sb->made.polyphase
+      && (ss->polyphase || ss->wintype == sb->made.wintype))
+    return;
+
+  memset((char *) sb->window, 0, n * sizeof(REAL));
+  if (ss->polyphase) {
+    RealFIR WOLAfir = newFIR_Lowpass_REAL(1.0, (REAL) sb->size, n - 1);
+    REAL MaxTap = 0;
+    memcpy((char *) sb->window, (char *) FIRcoef(WOLAfir), (n - 1) * sizeof(REAL));
+    for (i = 0; i < n; i++)
+      MaxTap = max(MaxTap, fabs(sb->window[i]));
+    MaxTap = 1.0f / MaxTap;
+    for (i = 0; i < n; i++)
+      sb->window[i] *= MaxTap;
+    delFIR_REAL(WOLAfir);
+  } else
+    makewindow(ss->wintype, sb->size, sb->window);
 
-  // where most recent signal started
-  j = sb->fill;
+  sb->made.polyphase = ss->polyphase;
+  sb->made.wintype = ss->wintype;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Boil output down to fewer bins 
+* 
+* in place; each of the width bins out covers an
+* equal share of the ones in
+*
+* @param out 
+* @param size 
+* @param width 
+* @param how SPEC_BIN_MAX, SPEC_BIN_MIN or SPEC_BIN_MEAN
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+bin_spectrum(REAL *out, int size, int width, int how) {
+  int i, k;
+  for (i = 0; i < width; i++) {
+    int lo = (int) ((long) i * size / width),
+        hi = (int) ((long) (i + 1) * size / width);
+    REAL v = out[lo];
+    for (k = lo + 1; k < hi; k++)
+      switch (how) {
+      case SPEC_BIN_MIN:
+	v = min(v, out[k]);
+	break;
+      case SPEC_BIN_MEAN:
+	v += out[k];
+	break;
+      default:
+	v = max(v, out[k]);
+	break;
+      }
+    if (how == SPEC_BIN_MEAN)
+      v /= hi - lo;
+    out[i] = v;
+  }
+}
 
-  // copy starting from there in circular fashion,
-  // applying window as we go
-  if (!sb->polyphase) {
+/* -------------------------------------------------------------------------- */
+/** @brief Window the snapshot into timebuf 
+* 
+* @param sb 
+* @param ss 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+window_complex(SpecBlock *sb, SpecSnap *ss) {
+  int i;
+  if (!ss->polyphase) {
+    for (i = 0; i < sb->size; i++)
+      CXBdata(sb->timebuf, i) = Cscl(CXBdata(ss->buf, i), sb->window[i]);
+  } else {
+    int k;
     for (i = 0; i < sb->size; i++) {
-      CXBdata(sb->timebuf, i) = Cscl(CXBdata(sb->accum, j), sb->window[i]);
-      j = (++j & sb->mask);
+      CXBreal(sb->timebuf, i) = CXBreal(ss->buf, i) * sb->window[i];
+      CXBimag(sb->timebuf, i) = CXBimag(ss->buf, i) * sb->window[i];
+      for (k = 1; k < 8; k++) {
+	int idx = i + k * sb->size;
+	CXBreal(sb->timebuf, i) += CXBreal(ss->buf, idx) * sb->window[idx];
+	CXBimag(sb->timebuf, i) += CXBimag(ss->buf, idx) * sb->window[idx];
+      }
     }
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Window a real snapshot into realbuf 
+* 
+* @param sb 
+* @param ss 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+window_real(SpecBlock *sb, SpecSnap *ss) {
+  int i;
+  if (!ss->polyphase) {
+    for (i = 0; i < sb->size; i++)
+      sb->realbuf[i] = CXBreal(ss->buf, i) * sb->window[i];
   } else {
     int k;
     for (i = 0; i < sb->size; i++) {
-      CXBreal(sb->timebuf, i) = CXBreal(sb->accum, j) * sb->window[i];
-      CXBimag(sb->timebuf, i) = CXBimag(sb->accum, j) * sb->window[i];
+      sb->realbuf[i] = CXBreal(ss->buf, i) * sb->window[i];
       for (k = 1; k < 8; k++) {
-	int accumidx = (j + k * sb->size) & sb->mask,
-	    winidx = i + k * sb->size;
-	CXBreal(sb->timebuf, i) +=
-	  CXBreal(sb->accum, accumidx) * sb->window[winidx];
-	CXBimag(sb->timebuf, i) +=
-	  CXBimag(sb->accum, accumidx) * sb->window[winidx];
+	int idx = i + k * sb->size;
+	sb->realbuf[i] += CXBreal(ss->buf, idx) * sb->window[idx];
       }
-      j = ++j & sb->mask;
     }
-
   }
-  sb->label = label;
-  sb->stamp = stamp;
-  sb->last = SPEC_LAST_FREQ;
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief cwFunction to take a snapshot of the oscilloscope 
+/** @brief Compute the spectrum block 
 * 
+* snapshot -> frequency domain, into output; then
+* averaged, peak-held and binned as its view says.
+* A real snapshot gets the real transform and only its
+* positive half, size/2 bins from zero up; the other
+* half would just be the mirror image.
+*
 * @param sb 
-* @param label 
-* @param stamp 
-* @return void
+* @param ss from claim_spectrum
+* @return int how many values in output
 */
 /* ---------------------------------------------------------------------------- */
-void
-snap_scope(SpecBlock *sb, int label, int stamp) {
-  int i, j;
+int
+compute_spectrum(SpecBlock *sb, SpecSnap *ss) {
+  int i, half = sb->size / 2,
+      n = ss->real ? half : sb->size,
+      zero = ss->real ? 0 : half;
+  SpecView *v = &ss->view;
+  REAL a = v->alpha, b = 1.0f - v->alpha;
+
+  fit_window(sb, ss);
+
+  // window the snapshot and transform
+  if (ss->real) {
+    window_real(sb, ss);
+    fftwf_execute(sb->rplan);
+  } else {
+    window_complex(sb, ss);
+    fftwf_execute(sb->plan);
+  }
+
+  // averages and peaks start over when what they're of changes
+  if (v->gen != sb->hist.gen || n != sb->hist.n)
+    sb->hist.gen = v->gen, sb->hist.n = n, sb->hist.primed = FALSE;
+
+  for (i = 0; i < n; i++) {
+    // zero frequency in the middle, or first if real
+    REAL p = Csqrmag(CXBdata(sb->freqbuf, (i + zero) & (sb->size - 1))),
+         *h = &sb->hist.avg[i], y;
+
+    switch (v->avg) {
+    case SPEC_AVG_LIN:
+      *h = sb->hist.primed ? a * *h + b * p : p;
+      y = ss->scale == SPEC_MAG ? (REAL) sqrt(*h) : Log10P(*h);
+      break;
+    case SPEC_AVG_LOG:
+      p = Log10P(p);
+      *h = sb->hist.primed ? a * *h + b * p : p;
+      y = ss->scale == SPEC_MAG ? (REAL) pow(10.0, *h / 20.0) : *h;
+      break;
+    default:
+      y = ss->scale == SPEC_MAG ? (REAL) sqrt(p) : Log10P(p);
+      break;
+    }
+
+    if (v->peak) {
+      h = &sb->hist.peak[i];
+      *h = sb->hist.primed ? max(*h, y) : y;
+      y = *h;
+    }
 
-  // where most recent signal started
-  j = sb->fill;
+    sb->output[i] = y;
+  }
+  sb->hist.primed = TRUE;
 
-  // copy starting from there in circular fashion
-  for (i = 0; i < sb->size; i++) {
-    sb->oscope[i] = CXBreal(sb->accum, j);
-    j = (++j & sb->mask);
+  if (v->width > 0 && v->width < n) {
+    bin_spectrum(sb->output, n, v->width, v->bin);
+    return v->width;
   }
+  return n;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Run-length code changes in quantized bins 
+* 
+* unit is 1 or 2 bytes. A control byte c under 128 is
+* followed by c + 1 units as they are; 128 and up stands
+* for c - 126 units that didn't change.
+*
+* @param d changes, mod the unit size
+* @param n 
+* @param unit 
+* @param buf 
+* @return int bytes
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+rle_spectrum(unsigned short *d, int n, int unit, char *buf) {
+  char *p = buf;
+  int i = 0;
 
-  sb->label = label;
-  sb->stamp = stamp;
-  sb->last = SPEC_LAST_TIME;
+  while (i < n) {
+    int r = 0;
+    while (i + r < n && r < 129 && d[i + r] == 0)
+      r++;
+    if (r >= 2) {
+      *p++ = (char) (r + 126);
+      i += r;
+    } else {
+      int k, m = 0;
+      // up to the next run worth coding
+      while (i + m < n && m < 128
+	     && !(d[i + m] == 0 && i + m + 1 < n && d[i + m + 1] == 0))
+	m++;
+      *p++ = (char) (m - 1);
+      for (k = 0; k < m; k++, i++)
+	if (unit == 1)
+	  *p++ = (char) d[i];
+	else
+	  memcpy(p, (char *) &d[i], 2), p += 2;
+    }
+  }
+  return p - buf;
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief Compute the spectrum block 
+/** @brief Pack a computed spectrum for the wire, quantized 
 * 
-* snapshot -> frequency domain
+* spectrum thread, from output, in the format v asks for.
+* Header is the magic word, format byte, flags byte, 16-bit
+* sequence number, 32-bit count, then float offset and scale:
+* a bin is offset + scale * code. Codes are 8 or 16 bits;
+* with delta, frames between whole ones carry only the
+* change in each code since frame seq-1, run-length coded.
 *
 * @param sb 
-* @return void
+* @param v view it was computed with
+* @param n how many in output
+* @param buf room for SPEC_WIRE_HEAD + 3 * n bytes
+* @return int bytes
 */
 /* ---------------------------------------------------------------------------- */
-void
-compute_spectrum(SpecBlock *sb) {
-  int i, j, half = sb->size / 2;
+int
+encode_spectrum(SpecBlock *sb, SpecView *v, int n, char *buf) {
+  unsigned int magic = SPEC_WIRE_MAGIC, count = n;
+  unsigned char fmt = (unsigned char) v->wire, flags = 0;
+  int i, unit = v->wire == SPEC_WIRE_U8 ? 1 : 2,
+      top = v->wire == SPEC_WIRE_U8 ? 255 : 65535;
+  REAL off, scl, *val = sb->output;
+  float f;
+  char *p = buf + SPEC_WIRE_HEAD;
 
-  // assume timebuf has windowed current snapshot
+  if (v->lo < v->hi)
+    off = v->lo, scl = (v->hi - v->lo) / top;
+  else {
+    REAL hi = off = val[0];
+    for (i = 1; i < n; i++)
+      off = min(off, val[i]), hi = max(hi, val[i]);
+    scl = hi > off ? (hi - off) / top : 1.0f;
+  }
 
-  fftwf_execute(sb->plan);
+  if (v->delta
+      && sb->wire.fmt == v->wire && sb->wire.n == n
+      && sb->wire.off == off && sb->wire.scl == scl
+      && ++sb->wire.since < SPEC_WIRE_KEY)
+    flags = SPEC_WIRE_DELTA;
+  else
+    sb->wire.since = 0;
 
-  if (sb->scale == SPEC_MAG) {
-    for (i = 0, j = half; i < half; i++, j++) {
-      sb->output[i] = Cmag(CXBdata(sb->freqbuf, j));
-      sb->output[j] = Cmag(CXBdata(sb->freqbuf, i));
-    }
-  } else {			// SPEC_PWR
-    for (i = 0, j = half; i < half; i++, j++) {
-      sb->output[i] = Log10P(Csqrmag(CXBdata(sb->freqbuf, j)));
-      sb->output[j] = Log10P(Csqrmag(CXBdata(sb->freqbuf, i)));
-    }
+  for (i = 0; i < n; i++) {
+    REAL c = (REAL) floor((val[i] - off) / scl + 0.5);
+    unsigned short q = (unsigned short) (c < 0 ? 0 : c > top ? top : c);
+    sb->wire.code[i] = (unsigned short) ((q - sb->wire.prev[i]) & top);
+    sb->wire.prev[i] = q;
+  }
+
+  if (flags & SPEC_WIRE_DELTA) {
+    int len = rle_spectrum(sb->wire.code, n, unit, p);
+    // a busy frame codes no smaller; send it whole instead
+    if (len < n * unit)
+      p += len;
+    else
+      flags = 0, sb->wire.since = 0;
   }
+  if (!(flags & SPEC_WIRE_DELTA))
+    for (i = 0; i < n; i++) {
+      if (unit == 1)
+	*p++ = (char) sb->wire.prev[i];
+      else
+	memcpy(p, (char *) &sb->wire.prev[i], 2), p += 2;
+    }
+
+  sb->wire.fmt = v->wire, sb->wire.n = n;
+  sb->wire.off = off, sb->wire.scl = scl;
+
+  memcpy(buf, (char *) &magic, 4);
+  buf[4] = fmt, buf[5] = flags;
+  memcpy(buf + 6, (char *) &sb->wire.seq, 2);
+  memcpy(buf + 8, (char *) &count, 4);
+  f = (float) off, memcpy(buf + 12, (char *) &f, 4);
+  f = (float) scl, memcpy(buf + 16, (char *) &f, 4);
+  sb->wire.seq++;
+
+  return p - buf;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Compute the scope block 
+* 
+* snapshot -> oscope
+*
+* @param sb 
+* @param ss from claim_spectrum
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+compute_scope(SpecBlock *sb, SpecSnap *ss) {
+  int i;
+  for (i = 0; i < sb->size; i++)
+    sb->oscope[i] = CXBreal(ss->buf, i);
 }
 
 /* -------------------------------------------------------------------------- */
 /** @brief Initialize the spectrum block 
 * 
+* buffers and plan for size; the settings (type, window,
+* view and so on) are left as they are
+*
 * @param sb 
 * @return void
 */
@@ -156,14 +547,29 @@ init_spectrum(SpecBlock *sb) {
   sb->freqbuf = newCXB(sb->size, 0, "spectrum freqbuf");
   sb->oscope = newvec_REAL(sb->size, "scope vec");
   sb->window = newvec_REAL(sb->size * 16, "spectrum window");
-  makewindow(BLACKMANHARRIS_WINDOW, sb->size, sb->window);
-  sb->mask = sb->size - 1;
-  sb->polyphase = FALSE;
+  makewindow(sb->wintype, sb->size, sb->window);
+  sb->made.polyphase = FALSE;
+  sb->made.wintype = sb->wintype;
+  sb->snap[0].buf = newCXB(sb->size * 8, 0, "spectrum snapshot");
+  sb->snap[1].buf = newCXB(sb->size * 8, 0, "spectrum snapshot");
+  sb->snap[0].stage = sb->snap[1].stage = SPEC_SNAP_IDLE;
+  sb->mask = (sb->polyphase ? 8 * sb->size : sb->size) - 1;
   sb->output = (float *) safealloc(sb->size, sizeof(float), "spectrum output");
+  sb->hist.avg = newvec_REAL(sb->size, "spectrum average");
+  sb->hist.peak = newvec_REAL(sb->size, "spectrum peak hold");
+  sb->hist.primed = FALSE;
+  sb->wire.prev = (unsigned short *) safealloc(sb->size, sizeof(unsigned short), "spectrum codes");
+  sb->wire.code = (unsigned short *) safealloc(sb->size, sizeof(unsigned short), "spectrum deltas");
+  sb->wire.n = sb->wire.since = 0;
   sb->plan = fftwf_plan_dft_1d(sb->size,
 			       (fftwf_complex *) CXBbase(sb->timebuf),
 			       (fftwf_complex *) CXBbase(sb->freqbuf),
 			       FFTW_FORWARD, sb->planbits);
+  sb->realbuf = newvec_REAL(sb->size, "spectrum real timebuf");
+  sb->rplan = fftwf_plan_dft_r2c_1d(sb->size,
+				    sb->realbuf,
+				    (fftwf_complex *) CXBbase(sb->freqbuf),
+				    sb->planbits);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -179,8 +585,7 @@ reinit_spectrum(SpecBlock *sb) {
   sb->fill = 0;
   if (sb->polyphase)
     polysize = 8;
-  memset((char *) CXBbase(sb->accum), 0, polysize * sb->size * sizeof(REAL));
-  memset((char *) sb->output, 0, sb->size * sizeof(float));
+  memset((char *) CXBbase(sb->accum), 0, polysize * sb->size * sizeof(COMPLEX));
 }
 
 /* -------------------------------------------------------------------------- */
@@ -192,13 +597,107 @@ reinit_spectrum(SpecBlock *sb) {
 /* ---------------------------------------------------------------------------- */
 void
 finish_spectrum(SpecBlock *sb) {
-  if (sb) {
+  if (sb && sb->accum) {
     delCXB(sb->accum);
     delCXB(sb->timebuf);
     delCXB(sb->freqbuf);
+    delCXB(sb->snap[0].buf);
+    delCXB(sb->snap[1].buf);
     delvec_REAL(sb->oscope);
     delvec_REAL(sb->window);
+    delvec_REAL(sb->hist.avg);
+    delvec_REAL(sb->hist.peak);
     safefree((char *) sb->output);
+    safefree((char *) sb->wire.prev);
+    safefree((char *) sb->wire.code);
+    delvec_REAL(sb->realbuf);
     fftwf_destroy_plan(sb->plan);
+    fftwf_destroy_plan(sb->rplan);
+    sb->accum = 0;
   }
 }
+
+/* -------------------------------------------------------------------------- */
+/** @brief Open a tap, or open it again at a new size 
+* 
+* DSP thread, from a command. Nothing's fed to it till
+* the spectrum thread has built it; see tend_spectrum.
+*
+* @param sb 
+* @param size 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+open_spectrum(SpecBlock *sb, int size) {
+  if (tap_spectrum(sb) == SPEC_TAP_ON && size == sb->size)
+    return;
+  // the spectrum thread may still be working at the old size
+  sb->want = size;
+  __sync_lock_test_and_set(&sb->state, SPEC_TAP_OPEN);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Close a tap 
+* 
+* DSP thread, from a command. It stops being fed at once;
+* the spectrum thread frees it.
+*
+* @param sb 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+close_spectrum(SpecBlock *sb) {
+  if (tap_spectrum(sb) != SPEC_TAP_OFF)
+    __sync_lock_test_and_set(&sb->state, SPEC_TAP_SHUT);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Where a tap is at 
+* 
+* either thread; only SPEC_TAP_ON may be fed or served
+*
+* @param sb 
+* @return int SPEC_TAP_*
+*/
+/* ---------------------------------------------------------------------------- */
+int
+tap_spectrum(SpecBlock *sb) {
+  return __sync_fetch_and_add(&sb->state, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Build or free a tap as asked 
+* 
+* spectrum thread, the only one that touches the buffers
+* of a tap that isn't on. Plans get made and destroyed
+* here, so the caller has to keep other planners out.
+* Asked again partway through, it goes around again.
+*
+* @param sb 
+* @return int SPEC_TAP_ON or SPEC_TAP_OFF
+*/
+/* ---------------------------------------------------------------------------- */
+int
+tend_spectrum(SpecBlock *sb) {
+  for (;;)
+    switch (tap_spectrum(sb)) {
+    case SPEC_TAP_OPEN:
+      if (__sync_bool_compare_and_swap(&sb->state, SPEC_TAP_OPEN, SPEC_TAP_BUILD)) {
+	finish_spectrum(sb);
+	sb->size = sb->want;
+	init_spectrum(sb);
+	__sync_bool_compare_and_swap(&sb->state, SPEC_TAP_BUILD, SPEC_TAP_ON);
+      }
+      break;
+    case SPEC_TAP_SHUT:
+      finish_spectrum(sb);
+      __sync_bool_compare_and_swap(&sb->state, SPEC_TAP_SHUT, SPEC_TAP_OFF);
+      break;
+    case SPEC_TAP_ON:
+      return SPEC_TAP_ON;
+    default:
+      return SPEC_TAP_OFF;
+    }
+}
@@ -57,32 +57,127 @@ Bridgewater, NJ 08807
 #define SPEC_LAST_TIME	(0)
 #define SPEC_LAST_FREQ	(1)  
 
+#define SPEC_AVG_NONE	(0)
+#define SPEC_AVG_LIN	(1)	// average power
+#define SPEC_AVG_LOG	(2)	// average dB
+#define SPEC_BIN_MAX	(0)
+#define SPEC_BIN_MIN	(1)
+#define SPEC_BIN_MEAN	(2)
+
+// how frames go out; see encode_spectrum
+#define SPEC_WIRE_FLOAT	(0)
+#define SPEC_WIRE_U8	(1)
+#define SPEC_WIRE_U16	(2)
+#define SPEC_WIRE_MAGIC	(0x51505344)	// "DSPQ", after label and stamp
+#define SPEC_WIRE_DELTA	(1)	// flag: run-length coded change since frame seq-1
+#define SPEC_WIRE_KEY	(32)	// a whole frame at least this often
+#define SPEC_WIRE_HEAD	(20)
+
+/// what's done with a frame before it goes out
+
+typedef
+struct _spec_view {
+  int avg,
+      bin,
+      gen,	// bumped when old averages and peaks no longer apply
+      width;	// bins to send, 0 for all of them
+  REAL alpha;	// weight on the running average
+  BOOLEAN peak;	// send the highest seen instead
+  int wire;
+  BOOLEAN delta;
+  REAL lo, hi;	// range quantized over; per frame if not lo < hi
+} SpecView;
+
+// where a tap is at; building and freeing are the spectrum thread's
+#define SPEC_TAP_OFF	(0)	// nothing there
+#define SPEC_TAP_OPEN	(1)	// wanted, at size
+#define SPEC_TAP_BUILD	(2)	// spectrum thread putting it together
+#define SPEC_TAP_ON	(3)	// fed and served
+#define SPEC_TAP_SHUT	(4)	// spectrum thread to take it apart
+
+// who has a snapshot
+#define SPEC_SNAP_IDLE	(0)	// nobody
+#define SPEC_SNAP_FILL	(1)	// DSP thread copying into it
+#define SPEC_SNAP_READY	(2)	// filled, waiting to be picked up
+#define SPEC_SNAP_BUSY	(3)	// spectrum thread working from it
+
+/// what the spectrum thread works from, so it needs no lock;
+/// everything about the request is carried along with it
+
+typedef
+struct _spec_snap {
+  int stage,
+      label,
+      last,
+      scale,
+      stamp;
+  BOOLEAN polyphase,
+          real;	// imaginary part all zero
+  Windowtype wintype;
+  SpecView view;
+  CXB buf;	// raw signal, oldest first
+} SpecSnap;
 
 typedef
 struct _spec_block {
-  BOOLEAN flag, polyphase;
+  BOOLEAN polyphase,
+          real;	// what's going into accum is
   Windowtype wintype;
+  REAL rate;	// what that's at
   int buflen,
       fill,
-      label,
-      last,
       mask,
       planbits,
       rxk,
       scale,
       size,
-      stamp,
+      want,	// size asked for, taken up when the tap is next built
+      state,
       type;
+  struct {
+    unsigned int addr;	// network order, 0 for here
+    unsigned short port;	// 0 for the spectrum port plus the tap number
+  } dest;
   CXB accum, timebuf, freqbuf;
-  REAL *output, *oscope, *window;
-  fftwf_plan plan;
+  REAL *output, *oscope, *window, *realbuf;
+  fftwf_plan plan, rplan;	// rplan: realbuf -> freqbuf, positive half
+  SpecSnap snap[2];
+  struct {
+    BOOLEAN polyphase;
+    Windowtype wintype;
+  } made;	// what window holds now
+  struct {
+    REAL fps, due;
+    int label,
+        fed;	// into accum since the last tick
+  } stream;	// pushed without being asked, if fps > 0
+  SpecView view;
+  struct {
+    REAL *avg, *peak;
+    int gen, n;
+    BOOLEAN primed;
+  } hist;	// spectrum thread's, for view
+  struct {
+    unsigned short *prev, *code, seq;
+    int fmt, n, since;
+    REAL off, scl;
+  } wire;	// spectrum thread's, for delta frames
 } SpecBlock;
 
 extern void init_spectrum(SpecBlock *sb);
 extern void reinit_spectrum(SpecBlock *sb);
+extern void open_spectrum(SpecBlock *sb, int size);
+extern void close_spectrum(SpecBlock *sb);
+extern int tap_spectrum(SpecBlock *sb);
+extern int tend_spectrum(SpecBlock *sb);
 extern void snap_spectrum(SpecBlock *sb, int label, int stamp);
 extern void snap_scope(SpecBlock *sb, int label, int stamp);
-extern void compute_spectrum(SpecBlock *sb);
+extern BOOLEAN tick_spectrum(SpecBlock *sb, int n, REAL rate);
+extern SpecSnap *claim_spectrum(SpecBlock *sb);
+extern void release_spectrum(SpecBlock *sb, SpecSnap *ss);
+extern int compute_spectrum(SpecBlock *sb, SpecSnap *ss);
+extern void compute_scope(SpecBlock *sb, SpecSnap *ss);
+extern int encode_spectrum(SpecBlock *sb, SpecView *v, int n, char *buf);
 extern void finish_spectrum(SpecBlock *sb);
 
 #endif
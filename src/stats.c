@@ -0,0 +1,236 @@
+/** 
+* @file stats.c
+* @brief Per-stage timing of the DSP chains 
+* @author DttSP contributors
+
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 by the DttSP contributors
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <common.h>
+
+char *rx_stat_names[] = {
+  "gain", "nb", "sdrom", "iq", "osc", "filt", "rsmp", "cpd",
+  "agc", "nr", "anf", "demod", "sql", "eq", "out", "misc", "total"
+};
+
+char *tx_stat_names[] = {
+  "gain", "wvs", "dcb", "sql", "eq", "lvl", "spr", "mod",
+  "filt", "cpd", "osc", "iq", "out", "misc", "total"
+};
+
+/* -------------------------------------------------------------------------- */
+/** @brief private bucket_of 
+* 
+* @param t 
+* @return int
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+bucket_of(TICKS t) {
+  int msb = 63 - __builtin_clzll(t | 1);
+  if (msb < STATS_SUBBITS)
+    return (int) t;
+  return (msb << STATS_SUBBITS)
+    | (int) ((t >> (msb - STATS_SUBBITS)) & ((1 << STATS_SUBBITS) - 1));
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private bucket_mid
+* 
+* @param b 
+* @return TICKS
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE TICKS
+bucket_mid(int b) {
+  int msb = b >> STATS_SUBBITS;
+  if (msb < STATS_SUBBITS)
+    return (TICKS) b;
+  else {
+    TICKS lo = ((TICKS) ((1 << STATS_SUBBITS) | (b & ((1 << STATS_SUBBITS) - 1))))
+               << (msb - STATS_SUBBITS);
+    return lo + ((TICKS) 1 << (msb - STATS_SUBBITS)) / 2;
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private stat_add 
+* 
+* @param ss 
+* @param t 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+stat_add(StageStat *ss, TICKS t) {
+  if (ss->n++ == 0)
+    ss->min = ss->max = t;
+  else {
+    if (t < ss->min) ss->min = t;
+    if (t > ss->max) ss->max = t;
+  }
+  ss->sum += t;
+  ss->hist[bucket_of(t)]++;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief reset_stats 
+*
+* clear everything and restart the clock calibration
+* 
+* @param sb 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+reset_stats(StatsBlock *sb) {
+  int k;
+  for (k = 0; k < MAXRX; k++)
+    memset((char *) &sb->rx[k], 0, sizeof(StatsChain));
+  memset((char *) &sb->tx, 0, sizeof(StatsChain));
+  sb->base.ticks = stats_now();
+  sb->base.tv = now_tv();
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief stats_start 
+*
+* top of a chain
+* 
+* @param sc 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+stats_start(StatsChain *sc) {
+  sc->first = sc->last = stats_now();
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief stats_lap 
+*
+* charge time since the last lap to stage
+* 
+* @param sc 
+* @param stage 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+stats_lap(StatsChain *sc, int stage) {
+  TICKS now = stats_now();
+  sc->acc[stage] += now - sc->last;
+  sc->hit[stage] = TRUE;
+  sc->last = now;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief stats_stop 
+*
+* bottom of a chain; commit this pass's laps,
+* and charge the whole pass to stage
+* 
+* @param sc 
+* @param stage 
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+stats_stop(StatsChain *sc, int stage) {
+  TICKS now = stats_now();
+  int i;
+
+  for (i = 0; i < MAXSTATS; i++)
+    if (sc->hit[i]) {
+      stat_add(&sc->stage[i], sc->acc[i]);
+      sc->acc[i] = 0;
+      sc->hit[i] = FALSE;
+    }
+  stat_add(&sc->stage[stage], now - sc->first);
+  sc->last = now;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief stats_ticks_per_usec 
+*
+* timestamp counter rate, measured against the wall clock
+* since the last reset
+* 
+* @param sb 
+* @return double
+*/
+/* ---------------------------------------------------------------------------- */
+double
+stats_ticks_per_usec(StatsBlock *sb) {
+#if defined(__i386__) || defined(__x86_64__)
+  TICKS ticks = stats_now();
+  struct timeval tv = now_tv(), dt = diff_tv(&tv, &sb->base.tv);
+  double usec = dt.tv_sec * 1e6 + dt.tv_usec;
+  return usec > 0.0 ? (ticks - sb->base.ticks) / usec : 1.0;
+#else
+  return 1000.0;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief stats_format 
+*
+* stage=count,min,mean,max,p99 for each stage seen, in usec
+* 
+* @param sb 
+* @param sc 
+* @param names 
+* @param nstage 
+* @param buff 
+* @param size 
+* @return char *
+*/
+/* ---------------------------------------------------------------------------- */
+char *
+stats_format(StatsBlock *sb, StatsChain *sc,
+	     char **names, int nstage,
+	     char *buff, int size) {
+  double tpu = stats_ticks_per_usec(sb);
+  int i, used = 0;
+
+  buff[0] = 0;
+  for (i = 0; i < nstage && used < size; i++) {
+    StageStat *ss = &sc->stage[i];
+    unsigned long want, seen;
+    int b;
+
+    if (ss->n == 0)
+      continue;
+
+    want = ss->n - ss->n / 100, seen = 0;
+    for (b = 0; b < STATS_BUCKETS; b++)
+      if ((seen += ss->hist[b]) >= want)
+	break;
+
+    used += snprintf(buff + used, size - used,
+		     " %s=%lu,%.2f,%.2f,%.2f,%.2f",
+		     names[i],
+		     ss->n,
+		     ss->min / tpu,
+		     (double) ss->sum / ss->n / tpu,
+		     ss->max / tpu,
+		     min(bucket_mid(b), ss->max) / tpu);
+  }
+  return buff;
+}
@@ -0,0 +1,132 @@
+// stats.h
+/*
+This file is part of a program that implements a Software-Defined Radio.
+
+Copyright (C) 2026 by the DttSP contributors
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _stats_h
+#define _stats_h
+
+#include <fromsys.h>
+#include <defs.h>
+#include <banal.h>
+#include <datatypes.h>
+
+/// per-stage timing of the RX and TX chains.
+/// a "lap" charges the time since the previous lap to a stage;
+/// when the block is off a lap costs one test.
+
+typedef unsigned long long TICKS;
+
+typedef enum {
+  RXSTAT_GAIN,
+  RXSTAT_NB,
+  RXSTAT_SDROM,
+  RXSTAT_IQ,
+  RXSTAT_OSC,
+  RXSTAT_FILT,
+  RXSTAT_RSMP,
+  RXSTAT_CPD,
+  RXSTAT_AGC,
+  RXSTAT_NR,
+  RXSTAT_ANF,
+  RXSTAT_DEMOD,
+  RXSTAT_SQL,
+  RXSTAT_EQ,
+  RXSTAT_OUT,
+  RXSTAT_MISC,
+  RXSTAT_TOTAL,
+  RXSTATS
+} RXSTATTYPE;
+
+typedef enum {
+  TXSTAT_GAIN,
+  TXSTAT_WVS,
+  TXSTAT_DCB,
+  TXSTAT_SQL,
+  TXSTAT_EQ,
+  TXSTAT_LVL,
+  TXSTAT_SPR,
+  TXSTAT_MOD,
+  TXSTAT_FILT,
+  TXSTAT_CPD,
+  TXSTAT_OSC,
+  TXSTAT_IQ,
+  TXSTAT_OUT,
+  TXSTAT_MISC,
+  TXSTAT_TOTAL,
+  TXSTATS
+} TXSTATTYPE;
+
+// log2 histogram, 4 steps per octave
+#define STATS_SUBBITS (2)
+#define STATS_BUCKETS (64 << STATS_SUBBITS)
+
+typedef struct _stage_stat {
+  unsigned long n;
+  TICKS sum, min, max;
+  unsigned int hist[STATS_BUCKETS];
+} StageStat;
+
+// room for whichever chain has more stages
+#define MAXSTATS ((int) RXSTATS > (int) TXSTATS ? (int) RXSTATS : (int) TXSTATS)
+
+// won't compile if a chain ever outgrows it
+typedef char stats_room_check[(MAXSTATS >= (int) RXSTATS && MAXSTATS >= (int) TXSTATS) ? 1 : -1];
+
+// laps add up over a pass, committed once per pass at the stop
+typedef struct _stats_chain {
+  TICKS first, last, acc[MAXSTATS];
+  BOOLEAN hit[MAXSTATS];
+  StageStat stage[MAXSTATS];
+} StatsChain;
+
+typedef struct _stats_block {
+  BOOLEAN flag;
+  struct {
+    TICKS ticks;
+    struct timeval tv;
+  } base;
+  StatsChain rx[MAXRX], tx;
+} StatsBlock;
+
+static INLINE TICKS
+stats_now(void) {
+#if defined(__i386__) || defined(__x86_64__)
+  unsigned int lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((TICKS) hi << 32) | lo;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (TICKS) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+extern void reset_stats(StatsBlock *sb);
+extern void stats_start(StatsChain *sc);
+extern void stats_lap(StatsChain *sc, int stage);
+extern void stats_stop(StatsChain *sc, int stage);
+extern double stats_ticks_per_usec(StatsBlock *sb);
+extern char *stats_format(StatsBlock *sb, StatsChain *sc,
+			  char **names, int nstage,
+			  char *buff, int size);
+
+extern char *rx_stat_names[], *tx_stat_names[];
+
+#endif
@@ -44,6 +44,51 @@ Bridgewater, NJ 08807
 
 #define RL (uni->multirx.lis)
 
+////////////////////////////////////////////////////////////////////////////
+/// for spectrum commands, which tap
+
+#define ST (uni->multispec.sel)
+
+////////////////////////////////////////////////////////////////////////////
+/// longest filter setRX/TXFiltTaps or setRX/TXFiltSpec will build
+
+#define MAXFILTTAPS (32768)
+
+extern void stage_rx_filt(int k, BOOLEAN fused);
+extern void swap_rx_filt(int k);
+extern void stage_tx_filt(void);
+extern void swap_tx_filt(void);
+extern void unstage_filt(void);
+extern void stage_rx_refit(int k, BOOLEAN flag, SDRMODE mode);
+extern void settle_resize(void);
+
+extern void want_rx_design(int k);
+extern void want_tx_design(void);
+extern void drop_rx_design(int k);
+extern void drop_tx_design(void);
+extern REAL design_bandpass(REAL lo, REAL hi, int taps, REAL beta, BOOLEAN minph,
+			    ComplexFIR *coef, FiltOvSv ovsv, COMPLEX *z);
+extern void fuse_rx_eq(int k, ComplexFIR coef, REAL scl,
+		       FiltOvSv ovsv, COMPLEX *z);
+extern void load_rx_design(int k);
+extern void refit_rx_filter(int k);
+
+////////////////////////////////////////////////////////////////////////////
+/// Commands with heavy lifting to do -- filter design, FFT plans,
+/// allocation -- do it in a prep (prep_cmds, below), which do_update
+/// runs on the command source's own thread while it holds upd,
+/// before the command is posted. The prep leaves what it built
+/// here, or in the filter stage in sdr.c, and the thunk proper only
+/// swaps it in on the DSP thread. unstage frees whatever is left
+/// once the DSP thread has let go of it.
+
+PRIVATE struct {
+  REAL *tbl;			// tx wave shaper table
+  int npts;
+} staged;
+
+PRIVATE void unstage(void);
+
 ////////////////////////////////////////////////////////////////////////////
 
 /* -------------------------------------------------------------------------- */
@@ -68,9 +113,6 @@ PRIVATE int
 setRXFilter(int n, char **p) {
   REAL low_frequency = atof(p[0]),
        high_frequency = atof(p[1]);
-  int i, ncoef = rx[RL]->len + 1, fftlen = 2 * rx[RL]->len;
-  fftwf_plan ptmp;
-  COMPLEX *zcvec;
 
   if (fabs(low_frequency) >= 0.5 * uni->rate.sample)
     return -1;
@@ -78,7 +120,6 @@ setRXFilter(int n, char **p) {
     return -2;
   if ((low_frequency + 10) >= high_frequency)
     return -3;
-  delFIR_COMPLEX(rx[RL]->filt.coef);
 
 #if 0
   fprintf(stderr, "setRXFilter %f %f\n", low_frequency, high_frequency);
@@ -87,30 +128,13 @@ setRXFilter(int n, char **p) {
   rx[RL]->filt.lo = low_frequency;
   rx[RL]->filt.hi = high_frequency;
 
-  rx[RL]->filt.coef = newFIR_Bandpass_COMPLEX(low_frequency,
-					      high_frequency,
-					      uni->rate.sample,
-					      ncoef);
-
-  zcvec = newvec_COMPLEX(fftlen, "filter z vec in setFilter");
-  ptmp = fftwf_plan_dft_1d(fftlen,
-			   (fftwf_complex *) zcvec,
-			   (fftwf_complex *) rx[RL]->filt.ovsv->zfvec,
-			   FFTW_FORWARD,
-			   uni->wisdom.bits);
-#ifdef LHS
-  for (i = 0; i < ncoef; i++)
-    zcvec[i] = rx[RL]->filt.coef->coef[i];
-#else
-  for (i = 0; i < ncoef; i++)
-    zcvec[fftlen - ncoef + i] = rx[RL]->filt.coef->coef[i];
-#endif
-  fftwf_execute(ptmp);
-  fftwf_destroy_plan(ptmp);
-  delvec_COMPLEX(zcvec);
-  normalize_vec_COMPLEX(rx[RL]->filt.ovsv->zfvec, rx[RL]->filt.ovsv->fftlen);
-  memcpy((char *) rx[RL]->filt.save, (char *) rx[RL]->filt.ovsv->zfvec,
-	 rx[RL]->filt.ovsv->fftlen * sizeof(COMPLEX));
+  // designed off the DSP thread, goes in at a later buffer
+  if (top->defer) {
+    want_rx_design(RL);
+    return 0;
+  }
+
+  load_rx_design(RL);
 
   return 0;
 }
@@ -124,19 +148,25 @@ getRXFilter(int n, char **p) {
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief private setRXFiltCoefs 
+/** @brief private prepRXFiltCoefs 
 * 
+* loads the new response into the filter's spare,
+* for setRXFiltCoefs to publish
+*
 * @param n 
 * @param *p 
 * @return int 
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
-setRXFiltCoefs(int n, char **p) {
-  int i, j, ncoef = rx[RL]->len + 1, fftlen = 2 * rx[RL]->len;
-  fftwf_plan ptmp;
-  COMPLEX *zcvec;
+prepRXFiltCoefs(int n, char **p) {
+  int i, j, ncoef = RXTAPS(RL);
+  FiltOvSv ovsv = rx[RL]->filt.ovsv;
+  COMPLEX *z;
+  REAL scl;
 
+  drop_rx_design(RL);
+  z = claim_OvSv(ovsv);
   delFIR_COMPLEX(rx[RL]->filt.coef);
 
   rx[RL]->filt.coef = newFIR_COMPLEX(ncoef, "setRXFiltCoefs");
@@ -146,29 +176,155 @@ setRXFiltCoefs(int n, char **p) {
   for (; i < ncoef; i++)
     FIRtap(rx[RL]->filt.coef, i) = cxzero;
 
-  zcvec = newvec_COMPLEX(fftlen, "filter z vec in setFilter");
-  ptmp = fftwf_plan_dft_1d(fftlen,
-			   (fftwf_complex *) zcvec,
-			   (fftwf_complex *) rx[RL]->filt.ovsv->zfvec,
-			   FFTW_FORWARD,
-			   uni->wisdom.bits);
-
-#ifdef LHS
-  for (i = 0; i < ncoef; i++)
-    zcvec[i] = FIRtap(rx[RL]->filt.coef, i);
-#else
-  for (i = 0; i < ncoef; i++)
-    zcvec[fftlen - ncoef + i] = FIRtap(rx[RL]->filt.coef, i);
-#endif
-
-  fftwf_execute(ptmp);
-  fftwf_destroy_plan(ptmp);
-  delvec_COMPLEX(zcvec);
-  normalize_vec_COMPLEX(rx[RL]->filt.ovsv->zfvec, rx[RL]->filt.ovsv->fftlen);
+  loadresp_OvSv(ovsv, z, FIRcoef(rx[RL]->filt.coef), ncoef, uni->wisdom.bits);
+  scl = normresp_OvSv(ovsv, z);
+  if (rx[RL]->grapheq.fused)
+    fuse_rx_eq(RL, rx[RL]->filt.coef, scl, ovsv, z);
   memcpy((char *) rx[RL]->filt.save,
-	 (char *) rx[RL]->filt.ovsv->zfvec,
-	 rx[RL]->filt.ovsv->fftlen * sizeof(COMPLEX));
+	 (char *) z,
+	 FiltOvSv_respsize(ovsv) * sizeof(COMPLEX));
+
+  return 0;
+}
 
+/* -------------------------------------------------------------------------- */
+/** @brief private setRXFiltCoefs 
+* 
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setRXFiltCoefs(int n, char **p) {
+  publish_OvSv(rx[RL]->filt.ovsv, uni->filt.fade);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setRXFiltTaps 
+* 
+* setRXFiltTaps <taps>
+* filter length independent of the buffer length,
+* 0 ties it to the buffer length again
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepRXFiltTaps(int n, char **p) {
+  int taps = atoi(p[0]);
+  if (taps < 0 || taps > MAXFILTTAPS)
+    return -1;
+  rx[RL]->filt.taps = taps;
+  stage_rx_filt(RL, rx[RL]->grapheq.fused);
+  return 0;
+}
+
+PRIVATE int
+setRXFiltTaps(int n, char **p) {
+  swap_rx_filt(RL);
+  return 0;
+}
+
+PRIVATE int
+getRXFiltTaps(int n, char **p) {
+  sprintf(top->resp.buff, "getRXFiltTaps %d %d\n",
+	  RXTAPS(RL), rx[RL]->filt.ovsv->npart);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+// read a filter spec off the command line; FALSE if it's no good
+
+PRIVATE BOOLEAN
+parse_filt_spec(int n, char **p, FIRSpec s) {
+  if (n != 3)
+    return FALSE;
+  s->ripple = atof(p[0]);
+  s->atten = atof(p[1]);
+  s->trans = atof(p[2]);
+  if (s->trans <= 0.0) {
+    s->trans = 0.0;
+    FIR_Kaiser_fit(s, uni->rate.sample, MAXFILTTAPS);
+    return TRUE;
+  }
+  if (s->ripple <= 0.0 || s->atten <= 0.0)
+    return FALSE;
+  return FIR_Kaiser_fit(s, uni->rate.sample, MAXFILTTAPS) > 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setRXFiltSpec 
+* 
+* setRXFiltSpec <ripple dB> <stopband dB> <transition Hz>
+* design the rx filter as short as will meet these,
+* Kaiser window; transition 0 goes back to setRXFiltTaps
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepRXFiltSpec(int n, char **p) {
+  FIRSpecDesc s;
+  if (!parse_filt_spec(n, p, &s))
+    return -1;
+  rx[RL]->filt.spec = s;
+  stage_rx_filt(RL, rx[RL]->grapheq.fused);
+  return 0;
+}
+
+PRIVATE int
+setRXFiltSpec(int n, char **p) {
+  swap_rx_filt(RL);
+  return 0;
+}
+
+PRIVATE int
+getRXFiltSpec(int n, char **p) {
+  sprintf(top->resp.buff, "getRXFiltSpec %f %f %f %d\n",
+	  rx[RL]->filt.spec.ripple,
+	  rx[RL]->filt.spec.atten,
+	  rx[RL]->filt.spec.trans,
+	  RXTAPS(RL));
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setRXFiltMinPhase 
+* 
+* setRXFiltMinPhase <0|1>
+* minimum-phase filter for this receiver: same magnitude
+* response, much less delay; for CW and break-in
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setRXFiltMinPhase(int n, char **p) {
+  rx[RL]->filt.minph = atoi(p[0]) ? TRUE : FALSE;
+
+  if (top->defer) {
+    want_rx_design(RL);
+    return 0;
+  }
+
+  load_rx_design(RL);
+
+  return 0;
+}
+
+PRIVATE int
+getRXFiltMinPhase(int n, char **p) {
+  sprintf(top->resp.buff, "getRXFiltMinPhase %d\n", rx[RL]->filt.minph);
+  top->resp.size = strlen(top->resp.buff);
   return 0;
 }
 
@@ -184,9 +340,7 @@ PRIVATE int
 setTXFilter(int n, char **p) {
   REAL low_frequency = atof(p[0]),
        high_frequency = atof(p[1]);
-  int i, ncoef = tx->len + 1, fftlen = 2 * tx->len;
-  fftwf_plan ptmp;
-  COMPLEX *zcvec;
+  int ncoef = TXTAPS;
 
   if (fabs(low_frequency) >= 0.5 * uni->rate.sample)
     return -1;
@@ -198,33 +352,18 @@ setTXFilter(int n, char **p) {
   tx->filt.lo = low_frequency;
   tx->filt.hi = high_frequency;
 
-  delFIR_COMPLEX(tx->filt.coef);
-  tx->filt.coef = newFIR_Bandpass_COMPLEX(low_frequency,
-					  high_frequency,
-					  uni->rate.sample,
-					  ncoef);
-
-  zcvec = newvec_COMPLEX(fftlen, "filter z vec in setFilter");
-  ptmp = fftwf_plan_dft_1d(fftlen,
-			   (fftwf_complex *) zcvec,
-			   (fftwf_complex *) tx->filt.ovsv->zfvec,
-			   FFTW_FORWARD,
-			   uni->wisdom.bits);
-
-#ifdef LHS
-  for (i = 0; i < ncoef; i++)
-    zcvec[i] = tx->filt.coef->coef[i];
-#else
-  for (i = 0; i < ncoef; i++)
-    zcvec[fftlen - ncoef + i] = tx->filt.coef->coef[i];
-#endif
-  fftwf_execute(ptmp);
-  fftwf_destroy_plan(ptmp);
-  delvec_COMPLEX(zcvec);
-  normalize_vec_COMPLEX(tx->filt.ovsv->zfvec, tx->filt.ovsv->fftlen);
+  if (top->defer) {
+    want_tx_design();
+    return 0;
+  }
+
+  design_bandpass(low_frequency, high_frequency, ncoef, TXBETA, FALSE,
+		  &tx->filt.coef,
+		  tx->filt.ovsv,
+		  tx->filt.ovsv->zfvec);
   memcpy((char *) tx->filt.save,
 	 (char *) tx->filt.ovsv->zfvec,
-	 tx->filt.ovsv->fftlen * sizeof(COMPLEX));
+	 FiltOvSv_respsize(tx->filt.ovsv) * sizeof(COMPLEX));
 
   return 0;
 }
@@ -238,7 +377,7 @@ getTXFilter(int n, char **p) {
 }
 
 /* -------------------------------------------------------------------------- */
-/** @brief private setTXFiltCoefs 
+/** @brief private prepTXFiltCoefs 
 * 
 * @param n 
 * @param *p 
@@ -246,11 +385,13 @@ getTXFilter(int n, char **p) {
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
-setTXFiltCoefs(int n, char **p) {
-  int i, j, ncoef = tx->len + 1, fftlen = 2 * tx->len;
-  fftwf_plan ptmp;
-  COMPLEX *zcvec;
+prepTXFiltCoefs(int n, char **p) {
+  int i, j, ncoef = TXTAPS;
+  FiltOvSv ovsv = tx->filt.ovsv;
+  COMPLEX *z;
 
+  drop_tx_design();
+  z = claim_OvSv(ovsv);
   delFIR_COMPLEX(tx->filt.coef);
 
   tx->filt.coef = newFIR_COMPLEX(ncoef, "setRXFiltCoefs");
@@ -260,29 +401,97 @@ setTXFiltCoefs(int n, char **p) {
   for (; i < ncoef; i++)
     FIRtap(tx->filt.coef, i) = cxzero;
 
-  zcvec = newvec_COMPLEX(fftlen, "filter z vec in setFilter");
-  ptmp = fftwf_plan_dft_1d(fftlen,
-			   (fftwf_complex *) zcvec,
-			   (fftwf_complex *) tx->filt.ovsv->zfvec,
-			   FFTW_FORWARD,
-			   uni->wisdom.bits);
-
-#ifdef LHS
-  for (i = 0; i < ncoef; i++)
-    zcvec[i] = FIRtap(tx->filt.coef, i);
-#else
-  for (i = 0; i < ncoef; i++)
-    zcvec[fftlen - ncoef + i] = FIRtap(tx->filt.coef, i);
-#endif
-
-  fftwf_execute(ptmp);
-  fftwf_destroy_plan(ptmp);
-  delvec_COMPLEX(zcvec);
-  normalize_vec_COMPLEX(rx[RL]->filt.ovsv->zfvec, tx->filt.ovsv->fftlen);
+  loadresp_OvSv(ovsv, z, FIRcoef(tx->filt.coef), ncoef, uni->wisdom.bits);
+  normresp_OvSv(ovsv, z);
   memcpy((char *) tx->filt.save,
-	 (char *) tx->filt.ovsv->zfvec,
-	 tx->filt.ovsv->fftlen * sizeof(COMPLEX));
+	 (char *) z,
+	 FiltOvSv_respsize(ovsv) * sizeof(COMPLEX));
+
+  return 0;
+}
 
+/* -------------------------------------------------------------------------- */
+/** @brief private setTXFiltCoefs 
+* 
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setTXFiltCoefs(int n, char **p) {
+  publish_OvSv(tx->filt.ovsv, uni->filt.fade);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setTXFiltTaps 
+* 
+* setTXFiltTaps <taps>
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepTXFiltTaps(int n, char **p) {
+  int taps = atoi(p[0]);
+  if (taps < 0 || taps > MAXFILTTAPS)
+    return -1;
+  tx->filt.taps = taps;
+  stage_tx_filt();
+  return 0;
+}
+
+PRIVATE int
+setTXFiltTaps(int n, char **p) {
+  swap_tx_filt();
+  return 0;
+}
+
+PRIVATE int
+getTXFiltTaps(int n, char **p) {
+  sprintf(top->resp.buff, "getTXFiltTaps %d %d\n",
+	  TXTAPS, tx->filt.ovsv->npart);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setTXFiltSpec 
+* 
+* setTXFiltSpec <ripple dB> <stopband dB> <transition Hz>
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepTXFiltSpec(int n, char **p) {
+  FIRSpecDesc s;
+  if (!parse_filt_spec(n, p, &s))
+    return -1;
+  tx->filt.spec = s;
+  stage_tx_filt();
+  return 0;
+}
+
+PRIVATE int
+setTXFiltSpec(int n, char **p) {
+  swap_tx_filt();
+  return 0;
+}
+
+PRIVATE int
+getTXFiltSpec(int n, char **p) {
+  sprintf(top->resp.buff, "getTXFiltSpec %f %f %f %d\n",
+	  tx->filt.spec.ripple,
+	  tx->filt.spec.atten,
+	  tx->filt.spec.trans,
+	  TXTAPS);
+  top->resp.size = strlen(top->resp.buff);
   return 0;
 }
 
@@ -309,6 +518,36 @@ setFilter(int n, char **p) {
   }
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief private setFilterFade 
+* 
+* setFilterFade <0|1>
+* crossfade over one buffer when a redesigned filter goes in
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setFilterFade(int n, char **p) {
+  uni->filt.fade = atoi(p[0]) ? TRUE : FALSE;
+  return 0;
+}
+
+PRIVATE int
+getFilterCache(int n, char **p) {
+  FiltCache c = uni->filt.cache;
+  int i, used = 0;
+  for (i = 0; i < c->size; i++)
+    if (c->ent[i].resp)
+      used++;
+  sprintf(top->resp.buff, "getFilterCache %d %d %lu %lu\n",
+	  used, c->size, c->hits, c->misses);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief private setMode 
 * 
@@ -319,6 +558,15 @@ setFilter(int n, char **p) {
 * @return int 
 */
 /* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepMode(int n, char **p) {
+  int mode = atoi(p[0]);
+  if (n > 1 && atoi(p[1]) == TX)
+    return 0;
+  stage_rx_refit(RL, rx[RL]->grapheq.flag, mode);
+  return 0;
+}
+
 PRIVATE int
 setMode(int n, char **p) {
   int mode = atoi(p[0]);
@@ -339,6 +587,7 @@ setMode(int n, char **p) {
     rx[RL]->am.gen->mode = AMdet;
   if (rx[RL]->mode == SAM)
     rx[RL]->am.gen->mode = SAMdet;
+  refit_rx_filter(RL);
   return 0;
 }
 
@@ -411,9 +660,10 @@ replay_updates(void) {
   char _str[4096], *str = _str;
   splitfld _splt, *splt = &_splt;
   BOOLEAN quiet = FALSE,
-          switcheroo = FALSE;
-  int oldRL, tmpRL;
-  extern CTE update_cmds[];
+          switcheroo = FALSE,
+          tapswitch;
+  int oldRL, tmpRL, oldST, tmpST;
+  extern CTE update_cmds[], prep_cmds[];
   FILE *log;
 
   log = top->verbose ? stderr : 0;
@@ -444,26 +694,48 @@ replay_updates(void) {
       switcheroo = TRUE;
     }
 
+    // same again for a spectrum tap
+    tapswitch = FALSE;
+    if (*str == '#') {
+      char *endp;
+      tmpST = strtol(++str, &endp, 10);
+      if (tmpST < 0 || tmpST >= MAXSPEC)
+	continue;
+      while (*endp && isspace(*endp))
+	endp++;
+      str = endp;
+      tapswitch = TRUE;
+    }
+
     split(splt, str);
 
     if (NF(splt) < 1)
       continue;
 
     else {
-      Thunk thk = Thunk_lookup(update_cmds, F(splt, 0));
+      Thunk thk = Thunk_lookup(update_cmds, F(splt, 0)),
+            prep = Thunk_lookup(prep_cmds, F(splt, 0));
       if (!thk)
 	continue;
 
       else {
-	int val;
+	int val = 0;
 
 	if (switcheroo)
 	  oldRL = RL, RL = tmpRL;
+	if (tapswitch)
+	  oldST = ST, ST = tmpST;
 
-	val = (*thk)(NF(splt) - 1, Fptr(splt, 1));
+	if (prep)
+	  val = (*prep)(NF(splt) - 1, Fptr(splt, 1));
+	if (val >= 0)
+	  val = (*thk)(NF(splt) - 1, Fptr(splt, 1));
+	unstage();
 
 	if (switcheroo)
 	  RL = oldRL;
+	if (tapswitch)
+	  ST = oldST;
 
 	if (log && !quiet) {
 	  int i;
@@ -841,10 +1113,10 @@ PRIVATE int
 setRXAGC(int n, char **p) {
   int setit = atoi(p[0]);
   rx[RL]->dttspagc.gen->mode = 1;
-  rx[RL]->dttspagc.gen->attack = 1.0 - exp(-1000 / (2.0 * uni->rate.sample));
+  rx[RL]->dttspagc.gen->attack = 1.0 - exp(-1000 / (2.0 * RXRATE));
   rx[RL]->dttspagc.gen->one_m_attack = 1.0 - rx[RL]->dttspagc.gen->attack;
   rx[RL]->dttspagc.gen->hangindex = rx[RL]->dttspagc.gen->indx = 0;
-  rx[RL]->dttspagc.gen->sndx = (int) (uni->rate.sample * 0.006f);
+  rx[RL]->dttspagc.gen->sndx = (int) (RXRATE * 0.006f);
   rx[RL]->dttspagc.gen->fastindx = FASTLEAD;
   switch (setit) {
   case agcOFF:
@@ -855,7 +1127,7 @@ setRXAGC(int n, char **p) {
     rx[RL]->dttspagc.gen->mode = agcSLOW;
     rx[RL]->dttspagc.gen->hangtime = 0.5;
     rx[RL]->dttspagc.gen->fasthangtime = 0.1;
-    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000 / (500.0 * uni->rate.sample));
+    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000 / (500.0 * RXRATE));
     rx[RL]->dttspagc.gen->one_m_decay = 1.0 - rx[RL]->dttspagc.gen->decay;
     rx[RL]->dttspagc.flag = TRUE;
     break;
@@ -863,7 +1135,7 @@ setRXAGC(int n, char **p) {
     rx[RL]->dttspagc.gen->mode = agcMED;
     rx[RL]->dttspagc.gen->hangtime = 0.25;
     rx[RL]->dttspagc.gen->fasthangtime = 0.1;
-    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000 / (250.0 * uni->rate.sample));
+    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000 / (250.0 * RXRATE));
     rx[RL]->dttspagc.gen->one_m_decay = 1.0 - rx[RL]->dttspagc.gen->decay;
     rx[RL]->dttspagc.flag = TRUE;
     break;
@@ -872,7 +1144,7 @@ setRXAGC(int n, char **p) {
     rx[RL]->dttspagc.gen->hangtime = 0.1;
     rx[RL]->dttspagc.gen->fasthangtime = 0.1;
     rx[RL]->dttspagc.gen->hangtime = 0.1;
-    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000 / (100.0 * uni->rate.sample));
+    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000 / (100.0 * RXRATE));
     rx[RL]->dttspagc.gen->one_m_decay = 1.0 - rx[RL]->dttspagc.gen->decay;
     rx[RL]->dttspagc.flag = TRUE;
     break;
@@ -881,7 +1153,7 @@ setRXAGC(int n, char **p) {
     rx[RL]->dttspagc.flag = TRUE;
     rx[RL]->dttspagc.gen->hangtime = 0.75;
     rx[RL]->dttspagc.gen->fasthangtime = 0.1;
-    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-0.5 / uni->rate.sample);
+    rx[RL]->dttspagc.gen->decay = 1.0 - exp(-0.5 / RXRATE);
     rx[RL]->dttspagc.gen->one_m_decay = 1.0 - rx[RL]->dttspagc.gen->decay;
     break;
   }
@@ -901,12 +1173,12 @@ setRXAGCAttack(int n, char **p) {
   REAL tmp = atof(p[0]);
   rx[RL]->dttspagc.gen->mode = 1;
   rx[RL]->dttspagc.gen->hangindex = rx[RL]->dttspagc.gen->indx = 0;
-  rx[RL]->dttspagc.gen->sndx = (int) (uni->rate.sample * 0.006);
+  rx[RL]->dttspagc.gen->sndx = (int) (RXRATE * 0.006);
   rx[RL]->dttspagc.gen->fasthangtime = 0.1;
   rx[RL]->dttspagc.gen->fastindx = FASTLEAD;
-  rx[RL]->dttspagc.gen->attack = 1.0 - exp(-1000.0 / (tmp * uni->rate.sample));
-  rx[RL]->dttspagc.gen->one_m_attack = exp(-1000.0 / (tmp * uni->rate.sample));
-  rx[RL]->dttspagc.gen->sndx = (int) (uni->rate.sample * tmp * 0.003);
+  rx[RL]->dttspagc.gen->attack = 1.0 - exp(-1000.0 / (tmp * RXRATE));
+  rx[RL]->dttspagc.gen->one_m_attack = exp(-1000.0 / (tmp * RXRATE));
+  rx[RL]->dttspagc.gen->sndx = (int) (RXRATE * tmp * 0.003);
   return 0;
 }
 
@@ -921,8 +1193,8 @@ setRXAGCAttack(int n, char **p) {
 PRIVATE int
 setRXAGCDecay(int n, char **p) {
   REAL tmp = atof(p[0]);
-  rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000.0 / (tmp * uni->rate.sample));
-  rx[RL]->dttspagc.gen->one_m_decay = exp(-1000.0 / (tmp * uni->rate.sample));
+  rx[RL]->dttspagc.gen->decay = 1.0 - exp(-1000.0 / (tmp * RXRATE));
+  rx[RL]->dttspagc.gen->one_m_decay = exp(-1000.0 / (tmp * RXRATE));
   return 0;
 }
 
@@ -1111,7 +1383,7 @@ gmean(REAL x, REAL y) { return sqrt(x * y); }
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
-setGrphRXEQ3(int n, char **p) {
+prepGrphRXEQ3(int n, char **p) {
   if (n < 4)
     return -1;
   else {
@@ -1131,37 +1403,39 @@ setGrphRXEQ3(int n, char **p) {
       gain[i] = preamp * rx[RL]->grapheq.parm.gain[i];
     }
 
-    tmpfilt = newFIR_Bandpass_COMPLEX(-400, 400, uni->rate.sample, 257);
+    tmpfilt = newFIR_Bandpass_COMPLEX(-400, 400, RXRATE, 257);
     for (i = 0; i < 257; i++)
       tmpcoef[i] = Cscl(tmpfilt->coef[i], gain[0]);
     delFIR_Bandpass_COMPLEX(tmpfilt);
 
-    tmpfilt = newFIR_Bandpass_COMPLEX(400, 1500, uni->rate.sample, 257);
+    tmpfilt = newFIR_Bandpass_COMPLEX(400, 1500, RXRATE, 257);
     for (i = 0; i < 257; i++)
       tmpcoef[i] = Cadd(tmpcoef[i], Cscl(tmpfilt->coef[i], gain[1]));
     delFIR_Bandpass_COMPLEX(tmpfilt);
 
-    tmpfilt = newFIR_Bandpass_COMPLEX(-1500, -400, uni->rate.sample, 257);
+    tmpfilt = newFIR_Bandpass_COMPLEX(-1500, -400, RXRATE, 257);
     for (i = 0; i < 257; i++)
       tmpcoef[i] = Cadd(tmpcoef[i], Cscl(tmpfilt->coef[i], gain[1]));
     delFIR_Bandpass_COMPLEX(tmpfilt);
 
-    tmpfilt = newFIR_Bandpass_COMPLEX(1500, 6000, uni->rate.sample, 257);
+    tmpfilt = newFIR_Bandpass_COMPLEX(1500, 6000, RXRATE, 257);
     for (i = 0; i < 257; i++)
       tmpcoef[i] = Cadd(tmpcoef[i], Cscl(tmpfilt->coef[i], gain[2]));
     delFIR_Bandpass_COMPLEX(tmpfilt);
 
-    tmpfilt = newFIR_Bandpass_COMPLEX(-6000, -1500, uni->rate.sample, 257);
+    tmpfilt = newFIR_Bandpass_COMPLEX(-6000, -1500, RXRATE, 257);
     for (i = 0; i < 257; i++)
       tmpcoef[i] = Cadd(tmpcoef[i], Cscl(tmpfilt->coef[i], gain[2]));
     delFIR_Bandpass_COMPLEX(tmpfilt);
 
     for (i = 0; i < 257; i++)
       filtcoef[254 + i] = tmpcoef[i];
+    memcpy((char *) rx[RL]->grapheq.gen->coef, (char *) tmpcoef,
+	   EQ_TAPS * sizeof(COMPLEX));
 
     ptmp = fftwf_plan_dft_1d(512,
 			     (fftwf_complex *) filtcoef,
-			     (fftwf_complex *) rx[RL]->grapheq.gen->p->zfvec,
+			     (fftwf_complex *) claim_OvSv(rx[RL]->grapheq.gen->p),
 			     FFTW_FORWARD,
 			     uni->wisdom.bits);
 
@@ -1174,6 +1448,13 @@ setGrphRXEQ3(int n, char **p) {
   return 0;
 }
 
+PRIVATE int
+setGrphRXEQ3(int n, char **p) {
+  publish_OvSv(rx[RL]->grapheq.gen->p, uni->filt.fade);
+  refit_rx_filter(RL);
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief private setGrphRXEQ10 
 * 
@@ -1183,7 +1464,7 @@ setGrphRXEQ3(int n, char **p) {
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
-setGrphRXEQ10(int n, char **p) {
+prepGrphRXEQ10(int n, char **p) {
   if (n < 11)
     return -1;
   else {
@@ -1208,12 +1489,18 @@ setGrphRXEQ10(int n, char **p) {
 	   f_above = gmean(f_here, f_here * 2.0),
 	   g_here  = dB2lin(gain[j]) * preamp;
 
-      tmpfilt = newFIR_Bandpass_COMPLEX(-f_above, -f_below, uni->rate.sample, 257);
+      // top bands can be out of reach at a decimated rate
+      if (f_below >= 0.5 * RXRATE)
+	break;
+      if (f_above > 0.5 * RXRATE)
+	f_above = 0.5 * RXRATE;
+
+      tmpfilt = newFIR_Bandpass_COMPLEX(-f_above, -f_below, RXRATE, 257);
       for (i = 0; i < 257; i++)
 	tmpcoef[i] = Cadd(tmpcoef[i], Cscl(tmpfilt->coef[i], g_here));
       delFIR_Bandpass_COMPLEX(tmpfilt);
 
-      tmpfilt = newFIR_Bandpass_COMPLEX(f_below, f_above, uni->rate.sample, 257);
+      tmpfilt = newFIR_Bandpass_COMPLEX(f_below, f_above, RXRATE, 257);
       for (i = 0; i < 257; i++)
 	tmpcoef[i] = Cadd(tmpcoef[i], Cscl(tmpfilt->coef[i], g_here));
       delFIR_Bandpass_COMPLEX(tmpfilt);
@@ -1221,10 +1508,12 @@ setGrphRXEQ10(int n, char **p) {
 
     for (i = 0; i < 257; i++)
       filtcoef[254 + i] = tmpcoef[i];
+    memcpy((char *) rx[RL]->grapheq.gen->coef, (char *) tmpcoef,
+	   EQ_TAPS * sizeof(COMPLEX));
 
     ptmp = fftwf_plan_dft_1d(512,
 			     (fftwf_complex *) filtcoef,
-			     (fftwf_complex *) rx[RL]->grapheq.gen->p->zfvec,
+			     (fftwf_complex *) claim_OvSv(rx[RL]->grapheq.gen->p),
 			     FFTW_FORWARD,
 			     uni->wisdom.bits);
 
@@ -1237,6 +1526,13 @@ setGrphRXEQ10(int n, char **p) {
   return 0;
 }
 
+PRIVATE int
+setGrphRXEQ10(int n, char **p) {
+  publish_OvSv(rx[RL]->grapheq.gen->p, uni->filt.fade);
+  refit_rx_filter(RL);
+  return 0;
+}
+
 PRIVATE int
 getGrphRXEQ(int n, char **p) {
   if (rx[RL]->grapheq.parm.size == 3)
@@ -1278,7 +1574,7 @@ getGrphRXEQ(int n, char **p) {
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
-setGrphTXEQ3(int n, char **p) {
+prepGrphTXEQ3(int n, char **p) {
   if (n < 4)
     return -1;
   else {
@@ -1327,7 +1623,7 @@ setGrphTXEQ3(int n, char **p) {
 
     ptmp = fftwf_plan_dft_1d(512,
 			     (fftwf_complex *) filtcoef,
-			     (fftwf_complex *) tx->grapheq.gen->p->zfvec,
+			     (fftwf_complex *) claim_OvSv(tx->grapheq.gen->p),
 			     FFTW_FORWARD,
 			     uni->wisdom.bits);
     fftwf_execute(ptmp);
@@ -1339,6 +1635,12 @@ setGrphTXEQ3(int n, char **p) {
   return 0;
 }
 
+PRIVATE int
+setGrphTXEQ3(int n, char **p) {
+  publish_OvSv(tx->grapheq.gen->p, uni->filt.fade);
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief private setGrphTXEQ10 
 * 
@@ -1348,7 +1650,7 @@ setGrphTXEQ3(int n, char **p) {
 */
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
-setGrphTXEQ10(int n, char **p) {
+prepGrphTXEQ10(int n, char **p) {
   if (n < 11)
     return -1;
   else {
@@ -1389,7 +1691,7 @@ setGrphTXEQ10(int n, char **p) {
 
     ptmp = fftwf_plan_dft_1d(512,
 			     (fftwf_complex *) filtcoef,
-			     (fftwf_complex *) tx->grapheq.gen->p->zfvec,
+			     (fftwf_complex *) claim_OvSv(tx->grapheq.gen->p),
 			     FFTW_FORWARD,
 			     uni->wisdom.bits);
 
@@ -1402,6 +1704,12 @@ setGrphTXEQ10(int n, char **p) {
   return 0;
 }
 
+PRIVATE int
+setGrphTXEQ10(int n, char **p) {
+  publish_OvSv(tx->grapheq.gen->p, uni->filt.fade);
+  return 0;
+}
+
 PRIVATE int
 getGrphTXEQ(int n, char **p) {
   if (tx->grapheq.parm.size == 3)
@@ -1801,25 +2109,32 @@ getTXSquelch(int n, char **p) {
 /***/
 
 PRIVATE int
-setTXWaveShapeFunc(int n, char **p) {
-  if (n < 2) {
-    if (tx->wvs.gen->tbl) {
-      delvec_REAL(tx->wvs.gen->tbl);
-      tx->wvs.gen->tbl = 0;
-    }
-    return 0;
-  } else {
-    int npts = atoi(p[0]);
-    REAL *temp = newvec_REAL(npts, "TX WaveShape table update temp");
-    {
-      int i;
+prepTXWaveShapeFunc(int n, char **p) {
+  // no table at all turns the shaper off
+  if (n >= 2) {
+    int i, npts = atoi(p[0]);
+    if (npts > n - 1)
+      return -1;
+    if (npts > 0) {
+      staged.tbl = newvec_REAL(npts + 1, "setWaveShaper table");
       for (i = 0; i < npts; i++)
-	temp[i] = atof(p[i + 1]);
+	staged.tbl[i] = atof(p[i + 1]);
+      staged.tbl[npts] = staged.tbl[npts - 1];
+      staged.npts = npts;
     }
-    setWaveShaper(tx->wvs.gen, npts, temp);
-    delvec_REAL(temp);
-    return 0;
   }
+  return 0;
+}
+
+PRIVATE int
+setTXWaveShapeFunc(int n, char **p) {
+  REAL *tbl = tx->wvs.gen->tbl;
+  int npts = tx->wvs.gen->npts;
+
+  // the old table goes back for unstage to free
+  tx->wvs.gen->tbl = staged.tbl, staged.tbl = tbl;
+  tx->wvs.gen->npts = staged.npts, staged.npts = npts;
+  return 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1939,8 +2254,8 @@ setSpotTone(int n, char **p) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
 setFinished(int n, char **p) {
+  // the update thread notices on its way around
   top->running = FALSE;
-  pthread_exit(0);
   return 0;
 }
 
@@ -2037,6 +2352,50 @@ setSNDSResetSize(int n, char **p) {
   return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief private getAudioStats 
+*
+* xruns, input overflows, output underflows,
+* late DSP passes out of total passes,
+* ring high-water marks in & out and ring size (frames),
+* longest pass and buffer period (usec)
+* 
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+getAudioStats(int n, char **p) {
+  sprintf(top->resp.buff, "getAudioStats %lu %lu %lu %lu %lu %lu %lu %lu %.1f %.1f\n",
+	  top->snds.stat.xrun,
+	  top->snds.stat.ovfl,
+	  top->snds.stat.unfl,
+	  top->snds.stat.late,
+	  top->snds.stat.pass,
+	  (unsigned long) top->snds.stat.hwm.i,
+	  (unsigned long) top->snds.stat.hwm.o,
+	  top->snds.ring.i.l ? (unsigned long) top->snds.ring.i.l->size : 0UL,
+	  top->snds.stat.worst,
+	  1e6 * top->hold.size.frames / uni->rate.sample);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setAudioStatsReset 
+* 
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setAudioStatsReset(int n, char **p) {
+  memset((char *) &top->snds.stat, 0, sizeof(top->snds.stat));
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief private setRXListen 
 * 
@@ -2354,15 +2713,21 @@ setGrphTXEQcmd(int n, char **p) {
 * @return int 
 */
 /* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepGrphRXEQcmd(int n, char **p) {
+  stage_rx_refit(RL, n < 1 ? FALSE : atoi(p[0]), rx[RL]->mode);
+  return 0;
+}
+
 PRIVATE int
 setGrphRXEQcmd(int n, char **p) {
-  if (n < 1) {
+  if (n < 1)
     rx[RL]->grapheq.flag = FALSE;
-    return 0;
-  } else {
+  else {
     BOOLEAN flag = atoi(p[0]);
     rx[RL]->grapheq.flag = flag;
   }
+  refit_rx_filter(RL);
   return 0;
 }
 
@@ -2417,36 +2782,18 @@ setTXCompand(int n, char **p) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
 setSpectrumPolyphase(int n, char **p) {
-  BOOLEAN setit = atoi(p[0]);
-  if (uni->spec.polyphase != setit) {
-    if (setit) {
-      uni->spec.polyphase = TRUE;
-      uni->spec.mask = (8 * uni->spec.size) - 1;
-      {
-	RealFIR WOLAfir;
-	REAL MaxTap = 0;
-	int i;
-	WOLAfir = newFIR_Lowpass_REAL(1.0,
-				      (REAL) uni->spec.size,
-				      8 * uni->spec.size - 1);
-	memset(uni->spec.window, 0, 8 * sizeof(REAL) * uni->spec.size);
-	memcpy(uni->spec.window,
-	       FIRcoef(WOLAfir),
-	       sizeof(REAL) * (8 * uni->spec.size - 1));
-	for (i = 0; i < 8 * uni->spec.size; i++)
-	  MaxTap = max(MaxTap, fabs(uni->spec.window[i]));
-	MaxTap = 1.0f / MaxTap;
-	for (i = 0; i < 8 * uni->spec.size; i++)
-	  uni->spec.window[i] *= MaxTap;
-	delFIR_REAL(WOLAfir);
-      }
-    } else {
-      uni->spec.polyphase = FALSE;
-      uni->spec.mask = uni->spec.size - 1;
-      memset(uni->spec.window, 0, sizeof(REAL) * uni->spec.size);
-      makewindow(uni->spec.wintype, uni->spec.size - 1, uni->spec.window);
-    }
-    reinit_spectrum(&uni->spec);
+  SpecBlock *sb = &uni->spec[ST];
+  BOOLEAN setit = atoi(p[0]) ? TRUE : FALSE;
+  if (sb->polyphase != setit) {
+    // the spectrum thread remakes the window to suit
+    sb->polyphase = setit;
+    sb->view.gen++;
+    if (tap_spectrum(sb) == SPEC_TAP_ON) {
+      sb->mask = (setit ? 8 * sb->size : sb->size) - 1;
+      reinit_spectrum(sb);
+    } else
+      // caught being built; have it built again to suit
+      __sync_bool_compare_and_swap(&sb->state, SPEC_TAP_BUILD, SPEC_TAP_OPEN);
   }
   return 0;
 }
@@ -2454,6 +2801,9 @@ setSpectrumPolyphase(int n, char **p) {
 /* -------------------------------------------------------------------------- */
 /** @brief private seSpectrumWindow 
 * 
+* only the windows makewindow knows by type;
+* Kaiser needs a shape it has no way to be given
+*
 * @param n 
 * @param *p 
 * @return int 
@@ -2461,10 +2811,11 @@ setSpectrumPolyphase(int n, char **p) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
 setSpectrumWindow(int n, char **p) {
-  Windowtype window = atoi(p[0]);
-  if (!uni->spec.polyphase)
-    makewindow(window, uni->spec.size, uni->spec.window);
-  uni->spec.wintype = window;
+  int type = atoi(p[0]);
+  if (type < RECTANGULAR_WINDOW || type >= KAISER_WINDOW)
+    return -1;
+  uni->spec[ST].wintype = type;
+  uni->spec[ST].view.gen++;
   return 0;
 }
 
@@ -2478,33 +2829,35 @@ setSpectrumWindow(int n, char **p) {
 /* ---------------------------------------------------------------------------- */
 PRIVATE int
 setSpectrumType(int n, char **p) {
-  uni->spec.type = SPEC_POST_FILT;
-  uni->spec.scale = SPEC_PWR;
-  uni->spec.rxk = RL;
+  uni->spec[ST].type = SPEC_POST_FILT;
+  uni->spec[ST].scale = SPEC_PWR;
+  uni->spec[ST].rxk = RL;
   switch (n) {
   case 3:
-    uni->spec.rxk = atoi(p[2]);
+    uni->spec[ST].rxk = atoi(p[2]);
   case 2:
-    uni->spec.scale = atoi(p[1]);
+    uni->spec[ST].scale = atoi(p[1]);
   case 1:
-    uni->spec.type = atoi(p[0]);
+    uni->spec[ST].type = atoi(p[0]);
     break;
   case 0:
     break;
   default:
     return -1;
   }
+  uni->spec[ST].view.gen++;
   return 0;
 }
 
 PRIVATE int
 getSpectrumInfo(int n, char **p) {
-  sprintf(top->resp.buff, "getSpectrumInfo %d %d %d %d %d\n",
-	  uni->spec.polyphase,
-	  uni->spec.wintype,
-	  uni->spec.type,
-	  uni->spec.scale,
-	  uni->spec.rxk);
+  sprintf(top->resp.buff, "getSpectrumInfo %d %d %d %d %d %f\n",
+	  uni->spec[ST].polyphase,
+	  uni->spec[ST].wintype,
+	  uni->spec[ST].type,
+	  uni->spec[ST].scale,
+	  uni->spec[ST].rxk,
+	  uni->spec[ST].rate);
   top->resp.size = strlen(top->resp.buff);
   return 0;
 }
@@ -2559,11 +2912,23 @@ setDCBlock(int n, char **p) {
 * @return int 
 */
 /* ---------------------------------------------------------------------------- */
+PRIVATE int
+prepNewBuflen(int n, char **p) {
+  extern int reset_for_buflen(int);
+  // live: built on the side, swapped in at a buffer boundary,
+  // state carries over, nothing to suspend or replay
+  if (top->defer)
+    return n == 1 ? reset_for_buflen(atoi(p[0])) : -1;
+  return 0;
+}
+
 PRIVATE int
 setNewBuflen(int n, char **p) {
   extern int reset_for_buflen(int);
   int rtn = -1;
   if (n == 1) {
+    if (top->defer)
+      return 0;
     top->susp = TRUE;
     if (reset_for_buflen(atoi(p[0])) != -1) {
       if (uni->update.flag)
@@ -2582,6 +2947,61 @@ getBuflen(int n, char **p) {
   return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief private setStats 
+*
+* setStats <0|1>
+* turning on clears the old numbers
+* 
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setStats(int n, char **p) {
+  if (n < 1)
+    return -1;
+  if ((uni->stats.flag = atoi(p[0])))
+    reset_stats(&uni->stats);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private getStats 
+*
+* getStats [trx [rx]]
+* stage=count,min,mean,max,p99 per stage, times in usec
+* 
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+getStats(int n, char **p) {
+  int trx = n > 0 ? atoi(p[0]) : RX,
+      used;
+
+  if (trx == TX) {
+    used = sprintf(top->resp.buff, "getStats %d", TX);
+    stats_format(&uni->stats, &uni->stats.tx,
+		 tx_stat_names, TXSTATS,
+		 top->resp.buff + used, sizeof(top->resp.buff) - used - 1);
+  } else {
+    int k = n > 1 ? atoi(p[1]) : RL;
+    if (k < 0 || k >= uni->multirx.nrx)
+      return -1;
+    used = sprintf(top->resp.buff, "getStats %d %d", RX, k);
+    stats_format(&uni->stats, &uni->stats.rx[k],
+		 rx_stat_names, RXSTATS,
+		 top->resp.buff + used, sizeof(top->resp.buff) - used - 1);
+  }
+  strcat(top->resp.buff, "\n");
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief private setTEST 
 * 
@@ -2616,15 +3036,9 @@ PRIVATE int
 setTestTone(int n, char **p) {
   if (n == 2) {
     REAL freq = atof(p[0]),
-         amp  = dB2lin(atof(p[1])),
-         phs  = OSCphase(top->test.tone.gen);
-    delOSC(top->test.tone.gen);
-    top->test.tone.gen = newOSC(top->hold.size.frames,
-				ComplexTone,
-				freq,
-				phs,
-				uni->rate.sample,
-				"test mode single tone");
+         amp  = dB2lin(atof(p[1]));
+    // same oscillator, phase carries on
+    OSCfreq(top->test.tone.gen) = 2.0 * M_PI * freq / uni->rate.sample;
     top->test.tone.amp = amp;
     return 0;
   }
@@ -2645,27 +3059,13 @@ PRIVATE int
 setTestTwoTone(int n, char **p) {
   if (n == 4) {
     REAL freq = atof(p[0]),
-         amp  = dB2lin(atof(p[1])),
-         phs  = OSCphase(top->test.twotone.a.gen);
-    delOSC(top->test.twotone.a.gen);
-    top->test.twotone.a.gen = newOSC(top->hold.size.frames,
-				     ComplexTone,
-				     freq,
-				     phs,
-				     uni->rate.sample,
-				     "test mode two tone A");
+         amp  = dB2lin(atof(p[1]));
+    OSCfreq(top->test.twotone.a.gen) = 2.0 * M_PI * freq / uni->rate.sample;
     top->test.twotone.a.amp = amp;
 
     freq = atof(p[2]),
-    amp  = dB2lin(atof(p[3])),
-    phs  = OSCphase(top->test.twotone.b.gen);
-    delOSC(top->test.twotone.b.gen);
-    top->test.twotone.b.gen = newOSC(top->hold.size.frames,
-				     ComplexTone,
-				     freq,
-				     phs,
-				     uni->rate.sample,
-				     "test mode two tone B");
+    amp  = dB2lin(atof(p[3]));
+    OSCfreq(top->test.twotone.b.gen) = 2.0 * M_PI * freq / uni->rate.sample;
     top->test.twotone.b.amp = amp;
 
     return 0;
@@ -2805,6 +3205,143 @@ reqTXMeter(int n, char **p) {
   return 0;
 }
 
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumAverage 
+* 
+* setSpectrumAverage <0 none|1 power|2 dB> [alpha]
+* exponential average over frames, alpha on the old one
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumAverage(int n, char **p) {
+  int avg;
+  REAL alpha = uni->spec[ST].view.alpha;
+  if (n < 1 || n > 2)
+    return -1;
+  avg = atoi(p[0]);
+  if (avg < SPEC_AVG_NONE || avg > SPEC_AVG_LOG)
+    return -2;
+  if (n > 1 && ((alpha = atof(p[1])) < 0.0 || alpha >= 1.0))
+    return -3;
+  uni->spec[ST].view.avg = avg;
+  uni->spec[ST].view.alpha = alpha;
+  uni->spec[ST].view.gen++;
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumPeakHold 
+* 
+* setSpectrumPeakHold <0|1>
+* frames carry the highest seen in each bin;
+* turning it on again starts over
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumPeakHold(int n, char **p) {
+  if (n != 1)
+    return -1;
+  uni->spec[ST].view.peak = atoi(p[0]) ? TRUE : FALSE;
+  uni->spec[ST].view.gen++;
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumBins 
+* 
+* setSpectrumBins <width> [0 max|1 min|2 mean]
+* send width bins, each standing for an equal share
+* of the full spectrum; 0 sends all of them
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumBins(int n, char **p) {
+  int width, bin = SPEC_BIN_MAX;
+  if (n < 1 || n > 2)
+    return -1;
+  width = atoi(p[0]);
+  if (width < 0 || width > uni->spec[ST].size)
+    return -2;
+  if (n > 1 && ((bin = atoi(p[1])) < SPEC_BIN_MAX || bin > SPEC_BIN_MEAN))
+    return -3;
+  uni->spec[ST].view.width = width;
+  uni->spec[ST].view.bin = bin;
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumFormat 
+* 
+* setSpectrumFormat <0 float|1 8-bit|2 16-bit> [delta [lo hi]]
+* quantize frames on the way out, over lo..hi if given,
+* otherwise over each frame's own range. delta sends only
+* what changed between whole frames, and needs lo..hi so
+* the codes mean the same thing from one frame to the next.
+* fetch_spectrum in port-clients.c decodes any of them.
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumFormat(int n, char **p) {
+  int wire;
+  BOOLEAN delta = FALSE;
+  REAL lo = 0.0, hi = 0.0;
+  if (n != 1 && n != 2 && n != 4)
+    return -1;
+  wire = atoi(p[0]);
+  if (wire < SPEC_WIRE_FLOAT || wire > SPEC_WIRE_U16)
+    return -2;
+  if (n > 1)
+    delta = atoi(p[1]) ? TRUE : FALSE;
+  if (n > 2 && (lo = atof(p[2])) >= (hi = atof(p[3])))
+    return -3;
+  if (delta && !(lo < hi))
+    return -4;
+  uni->spec[ST].view.wire = wire;
+  uni->spec[ST].view.delta = delta;
+  uni->spec[ST].view.lo = lo;
+  uni->spec[ST].view.hi = hi;
+  return 0;
+}
+
+PRIVATE int
+getSpectrumFormat(int n, char **p) {
+  sprintf(top->resp.buff, "getSpectrumFormat %d %d %f %f\n",
+	  uni->spec[ST].view.wire,
+	  uni->spec[ST].view.delta,
+	  uni->spec[ST].view.lo,
+	  uni->spec[ST].view.hi);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+PRIVATE int
+getSpectrumView(int n, char **p) {
+  sprintf(top->resp.buff, "getSpectrumView %d %f %d %d %d\n",
+	  uni->spec[ST].view.avg,
+	  uni->spec[ST].view.alpha,
+	  uni->spec[ST].view.peak,
+	  uni->spec[ST].view.width,
+	  uni->spec[ST].view.bin);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief private ReqSpectrum 
 * 
@@ -2818,7 +3355,131 @@ reqTXMeter(int n, char **p) {
 
 PRIVATE int
 reqSpectrum(int n, char **p) {
-  snap_spectrum(&uni->spec, n > 0 ? atoi(p[0]) : 0, uni->tick);
+  if (!uni->multispec.flag || tap_spectrum(&uni->spec[ST]) != SPEC_TAP_ON)
+    return -1;
+  snap_spectrum(&uni->spec[ST], n > 0 ? atoi(p[0]) : 0, uni->tick);
+  sem_post(top->sync.pws.sem);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumStream 
+* 
+* setSpectrumStream <fps> [label]
+* send spectra to the tap's port fps times a second
+* without being asked; 0 stops it. Frames carry label
+* and the tick they were taken at, same as reqSpectrum.
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumStream(int n, char **p) {
+  REAL fps;
+  if (n < 1 || n > 2 || !uni->multispec.flag)
+    return -1;
+  if ((fps = atof(p[0])) < 0.0)
+    return -2;
+  uni->spec[ST].stream.fps = fps;
+  uni->spec[ST].stream.label = n > 1 ? atoi(p[1]) : 0;
+  // first frame at the next buffer
+  uni->spec[ST].stream.due = uni->rate.sample;
+  return 0;
+}
+
+PRIVATE int
+getSpectrumStream(int n, char **p) {
+  sprintf(top->resp.buff, "getSpectrumStream %f %d\n",
+	  uni->spec[ST].stream.fps, uni->spec[ST].stream.label);
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumTap 
+* 
+* setSpectrumTap <k>
+* spectrum commands after this go to tap k; a single
+* command can go elsewhere with a #k prefix, the way
+* @k does for receivers
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumTap(int n, char **p) {
+  int k;
+  if (n != 1)
+    return -1;
+  if ((k = atoi(p[0])) < 0 || k >= MAXSPEC)
+    return -2;
+  ST = k;
+  return 0;
+}
+
+PRIVATE int
+getSpectrumTap(int n, char **p) {
+  SpecBlock *sb = &uni->spec[ST];
+  struct in_addr addr;
+  addr.s_addr = sb->dest.addr;
+  sprintf(top->resp.buff, "getSpectrumTap %d %d %d %d %s\n",
+	  ST,
+	  tap_spectrum(sb),
+	  sb->want,
+	  sb->dest.port ? sb->dest.port : top->meas.spec.port + ST,
+	  sb->dest.addr ? inet_ntoa(addr) : "-");
+  top->resp.size = strlen(top->resp.buff);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief private setSpectrumTapOn 
+* 
+* setSpectrumTapOn [size [port [host]]]
+* open the tap, or open it again at a new size. Frames go
+* to port on host, by default the spectrum port plus the
+* tap number on this machine. The receiver and tap point,
+* window, view, format and stream rate are the tap's own,
+* set with the usual commands; tap 0 is on from the start.
+*
+* @param n 
+* @param *p 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+setSpectrumTapOn(int n, char **p) {
+  SpecBlock *sb = &uni->spec[ST];
+  int size = sb->want, port = sb->dest.port;
+  struct in_addr addr;
+  addr.s_addr = sb->dest.addr;
+  if (n > 3 || !uni->multispec.flag)
+    return -1;
+  // a power of 2 that a whole buffer fits in, and a float frame a datagram
+  if (n > 0 && (popcnt(size = atoi(p[0])) != 1
+		|| size > 8192 || 8 * size < uni->buflen))
+    return -2;
+  if (n > 1 && ((port = atoi(p[1])) < 0 || port > 65535))
+    return -3;
+  if (n > 2 && !inet_aton(p[2], &addr))
+    return -4;
+  sb->dest.port = port;
+  sb->dest.addr = addr.s_addr;
+  open_spectrum(sb, size);
+  sem_post(top->sync.pws.sem);
+  return 0;
+}
+
+PRIVATE int
+setSpectrumTapOff(int n, char **p) {
+  if (!uni->multispec.flag || tap_spectrum(&uni->spec[ST]) == SPEC_TAP_OFF)
+    return -1;
+  // streaming picks up where it was if it's opened again
+  close_spectrum(&uni->spec[ST]);
   sem_post(top->sync.pws.sem);
   return 0;
 }
@@ -2836,7 +3497,9 @@ reqSpectrum(int n, char **p) {
 
 PRIVATE int
 reqScope(int n, char **p) {
-  snap_scope(&uni->spec, n > 0 ? atoi(p[0]) : 0, uni->tick);
+  if (!uni->multispec.flag || tap_spectrum(&uni->spec[ST]) != SPEC_TAP_ON)
+    return -1;
+  snap_scope(&uni->spec[ST], n > 0 ? atoi(p[0]) : 0, uni->tick);
   sem_post(top->sync.pws.sem);
   return 0;
 }
@@ -2872,6 +3535,7 @@ CTE update_cmds[] = {
   {"reqTXMeter", reqTXMeter},
 
   {"setANF", setANF},
+  {"setAudioStatsReset", setAudioStatsReset},
   {"setANFvals", setANFvals},
   {"setBIN", setBIN},
   {"setBlkANF", setBlkANF},
@@ -2883,6 +3547,7 @@ CTE update_cmds[] = {
   {"setDCBlock", setDCBlock},
   {"setDCBlockSt", setDCBlockSt},
   {"setFilter", setFilter},
+  {"setFilterFade", setFilterFade},
   {"setFinished", setFinished},
   {"setGain", setGain},
   {"setGrphRXEQ10", setGrphRXEQ10},
@@ -2910,6 +3575,9 @@ CTE update_cmds[] = {
   {"setRXAGCSlope", setRXAGCSlope},
   {"setRXAGCTop", setRXAGCTop},
   {"setRXFiltCoefs", setRXFiltCoefs},
+  {"setRXFiltTaps", setRXFiltTaps},
+  {"setRXFiltSpec", setRXFiltSpec},
+  {"setRXFiltMinPhase", setRXFiltMinPhase},
   {"setRXListen", setRXListen},
   {"setRXOff", setRXOff},
   {"setRXOn", setRXOn},
@@ -2921,13 +3589,22 @@ CTE update_cmds[] = {
   {"setSDROMvals", setSDROMvals},
   {"setSNDSResetSize", setSNDSResetSize},
   {"setSWCH", setSWCH},
+  {"setSpectrumAverage", setSpectrumAverage},
+  {"setSpectrumBins", setSpectrumBins},
+  {"setSpectrumFormat", setSpectrumFormat},
+  {"setSpectrumPeakHold", setSpectrumPeakHold},
   {"setSpectrumPolyphase", setSpectrumPolyphase},
+  {"setSpectrumStream", setSpectrumStream},
+  {"setSpectrumTap", setSpectrumTap},
+  {"setSpectrumTapOff", setSpectrumTapOff},
+  {"setSpectrumTapOn", setSpectrumTapOn},
   {"setSpectrumType", setSpectrumType},
   {"setSpectrumWindow", setSpectrumWindow},
   {"setSpotTone", setSpotTone},
   {"setSpotToneVals", setSpotToneVals},
   {"setSquelch", setSquelch},
   {"setSquelchSt", setSquelchSt},
+  {"setStats", setStats},
   {"setTEST", setTEST},
   {"setTRX", setTRX},
   {"setTXAGCFF", setTXAGCFF},
@@ -2936,6 +3613,8 @@ CTE update_cmds[] = {
   {"setTXCompand", setTXCompand},
   {"setTXCompandSt", setTXCompandSt},
   {"setTXFiltCoefs", setTXFiltCoefs},
+  {"setTXFiltTaps", setTXFiltTaps},
+  {"setTXFiltSpec", setTXFiltSpec},
   {"setTXLevelerAttack", setTXLevelerAttack},
   {"setTXLevelerDecay", setTXLevelerDecay},
   {"setTXLevelerHang", setTXLevelerHang},
@@ -2962,6 +3641,7 @@ CTE update_cmds[] = {
 
   {"getANF", getANF},
   {"getANR", getANR},
+  {"getAudioStats", getAudioStats},
   {"getBIN", getBIN},
   {"getBlkANF", getBlkNR},
   {"getBlkNR", getBlkNR},
@@ -2974,6 +3654,10 @@ CTE update_cmds[] = {
   {"getRXCompand", getRXCompand},
   {"getRXCount", getRXCount},
   {"getRXFilter", getRXFilter},
+  {"getFilterCache", getFilterCache},
+  {"getRXFiltTaps", getRXFiltTaps},
+  {"getRXFiltSpec", getRXFiltSpec},
+  {"getRXFiltMinPhase", getRXFiltMinPhase},
   {"getRXGain", getRXGain},
   {"getRXIQ", getRXIQ},
   {"getRXListen", getRXListen},
@@ -2983,12 +3667,19 @@ CTE update_cmds[] = {
   {"getRXSquelch", getRXSquelch},
   {"getSDROM", getSDROM},
   {"getSpectrumInfo", getSpectrumInfo},
+  {"getSpectrumFormat", getSpectrumFormat},
+  {"getSpectrumStream", getSpectrumStream},
+  {"getSpectrumTap", getSpectrumTap},
+  {"getSpectrumView", getSpectrumView},
   {"getSpotTone", getSpotTone},
+  {"getStats", getStats},
   {"getTEST", getTEST},
   {"getTRX", getTRX},
   {"getTXCarrierLevel", getTXCarrierLevel},
   {"getTXCompand", getTXCompand},
   {"getTXFilter", getTXFilter},
+  {"getTXFiltTaps", getTXFiltTaps},
+  {"getTXFiltSpec", getTXFiltSpec},
   {"getTXGain", getTXGain},
   {"getTXIQ", getTXIQ},
   {"getTXLeveler", getTXLeveler},
@@ -3004,6 +3695,103 @@ CTE update_cmds[] = {
 
 //........................................................................
 
+/// the heavy half of commands that have one, see staged above
+
+CTE prep_cmds[] = {
+  {"setGrphRXEQ3", prepGrphRXEQ3},
+  {"setGrphRXEQ10", prepGrphRXEQ10},
+  {"setGrphRXEQcmd", prepGrphRXEQcmd},
+  {"setGrphTXEQ3", prepGrphTXEQ3},
+  {"setGrphTXEQ10", prepGrphTXEQ10},
+  {"setMode", prepMode},
+  {"setNewBuflen", prepNewBuflen},
+  {"setRXFiltCoefs", prepRXFiltCoefs},
+  {"setRXFiltSpec", prepRXFiltSpec},
+  {"setRXFiltTaps", prepRXFiltTaps},
+  {"setTXFiltCoefs", prepTXFiltCoefs},
+  {"setTXFiltSpec", prepTXFiltSpec},
+  {"setTXFiltTaps", prepTXFiltTaps},
+  {"setTXWaveShapeFunc", prepTXWaveShapeFunc},
+
+  {0, 0}
+};
+
+/* -------------------------------------------------------------------------- */
+/** @brief private unstage 
+* 
+* free what a command's thunk swapped out, or what its prep
+* built if the thunk never ran; command thread, after the ack
+*
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE void
+unstage(void) {
+  if (staged.tbl)
+    delvec_REAL(staged.tbl);
+  staged.tbl = 0;
+  staged.npts = 0;
+  unstage_filt();
+}
+
+//........................................................................
+
+/// one command at a time in flight,
+/// handed to the DSP thread through a single pointer
+
+PRIVATE struct _pending {
+  Thunk thk;
+  int n, rl, st, val;
+  char **p;
+  BOOLEAN sw, ts;
+} pending, *volatile posted = 0;
+
+/* -------------------------------------------------------------------------- */
+/** @brief private run_update 
+* 
+* @param thk the command's thunk, or its prep
+* @param pp 
+* @return int 
+*/
+/* ---------------------------------------------------------------------------- */
+PRIVATE int
+run_update(Thunk thk, struct _pending *pp) {
+  int oldRL = RL, oldST = ST;
+
+  if (pp->sw)
+    RL = pp->rl;
+  if (pp->ts)
+    ST = pp->st;
+
+  pp->val = (*thk)(pp->n, pp->p);
+
+  if (pp->sw)
+    RL = oldRL;
+  if (pp->ts)
+    ST = oldST;
+
+  return pp->val;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief drain_updates 
+* 
+* called by the DSP thread between buffers;
+*   runs the command posted by do_update, if any,
+*   then lets do_update go. Never waits.
+*
+* @return void
+*/
+/* ---------------------------------------------------------------------------- */
+void
+drain_updates(void) {
+  struct _pending *pp = __sync_lock_test_and_set(&posted, 0);
+  if (pp) {
+    run_update(pp->thk, pp);
+    sem_post(top->sync.ack.sem);
+  }
+}
+
 /* -------------------------------------------------------------------------- */
 /** @brief do_update 
 * 
@@ -3015,8 +3803,9 @@ CTE update_cmds[] = {
 int
 do_update(char *str, FILE *log) {
   BOOLEAN quiet = FALSE,
-          switcheroo = FALSE;
-  int oldRL, tmpRL;
+          switcheroo = FALSE,
+          tapswitch = FALSE;
+  int tmpRL = 0, tmpST = 0;
   SPLIT splt = &uni->update.splt;
 
   // append to replay file?
@@ -3044,29 +3833,68 @@ do_update(char *str, FILE *log) {
     switcheroo = TRUE;
   }
 
+  // same again for a spectrum tap
+  if (*str == '#') {
+    char *endp;
+    tmpST = strtol(++str, &endp, 10);
+    if (tmpST < 0 || tmpST >= MAXSPEC)
+      return -1;
+    while (*endp && isspace(*endp))
+      endp++;
+    str = endp;
+    tapswitch = TRUE;
+  }
+
   split(splt, str);
 
   if (NF(splt) < 1)
     return -1;
 
   else {
-    Thunk thk = Thunk_lookup(update_cmds, F(splt, 0));
+    Thunk thk = Thunk_lookup(update_cmds, F(splt, 0)),
+          prep = Thunk_lookup(prep_cmds, F(splt, 0));
     if (!thk)
       return -1;
     else {
       int val;
 
-      sem_wait(top->sync.upd.sem);
-
-      if (switcheroo)
-	oldRL = RL, RL = tmpRL;
+      // upd now only keeps command sources out of each other's way;
+      // the DSP thread never takes it
+
+      if (top->defer)
+	sem_wait(top->sync.upd.sem);
+
+      pending.thk = thk;
+      pending.n = NF(splt) - 1;
+      pending.p = Fptr(splt, 1);
+      pending.sw = switcheroo;
+      pending.rl = tmpRL;
+      pending.ts = tapswitch;
+      pending.st = tmpST;
+
+      // heavy lifting here, on our own thread,
+      // against the buffer length the thunk will see
+      val = 0;
+      if (prep) {
+	settle_resize();
+	val = run_update(prep, &pending);
+      }
 
-      val = (*thk)(NF(splt) - 1, Fptr(splt, 1));
+      if (val >= 0) {
+	if (top->defer) {
+	  // publish, wake the DSP thread, wait for the next buffer boundary
+	  __sync_bool_compare_and_swap(&posted, 0, &pending);
+	  sem_post(top->sync.buf.sem);
+	  sem_wait(top->sync.ack.sem);
+	  val = pending.val;
+	} else
+	  val = run_update(thk, &pending);
+      }
 
-      if (switcheroo)
-	RL = oldRL;
+      unstage();
 
-      sem_post(top->sync.upd.sem);
+      if (top->defer)
+	sem_post(top->sync.upd.sem);
 
       if (log && !quiet) {
 	int i;
@@ -42,5 +42,6 @@ Bridgewater, NJ 08807
 #include <thunk.h>
 
 extern int do_update(char *str, FILE *log);
+extern void drain_updates(void);
 
 #endif
@@ -92,7 +92,7 @@ newWaveShaper(CXB buff) {
   WaveShaper wvs;
 
   wvs = (WaveShaper) safealloc(1,
-			       sizeof(WaveShaper),
+			       sizeof(WaveShaperinfo),
 			       "WaveShaper struct");
   wvs->npts = 0;
   wvs->tbl = 0;
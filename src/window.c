@@ -194,3 +194,51 @@ makewindow(Windowtype type, int size, REAL *window) {
 
   return window;
 }
+
+/* -------------------------------------------------------------------------- */
+/** @brief Zeroth-order modified Bessel function, by its series
+* 
+* @param x 
+* @return double
+*/
+/* ---------------------------------------------------------------------------- */
+static double
+bessel_i0(double x) {
+  double sum = 1.0, term = 1.0, half = x / 2.0;
+  int k;
+  for (k = 1; term > 1e-12 * sum; k++) {
+    term *= (half / k) * (half / k);
+    sum += term;
+  }
+  return sum;
+}
+
+/* -------------------------------------------------------------------------- */
+/** @brief Function to make a Kaiser window 
+*
+* beta trades main lobe width for sidelobe level;
+* 0 is rectangular
+* 
+* @param size -- size of window 
+* @param beta -- shape 
+* @param window -- data 
+* @return *REAL  
+*/
+/* ---------------------------------------------------------------------------- */
+REAL *
+makekaiser(int size, REAL beta, REAL *window) {
+  int i;
+  double norm = bessel_i0(beta);
+
+  if (size == 1) {
+    window[0] = 1.0;
+    return window;
+  }
+
+  for (i = 0; i < size; i++) {
+    double r = 2.0 * i / (size - 1) - 1.0;
+    window[i] = (REAL) (bessel_i0(beta * sqrt(1.0 - r * r)) / norm);
+  }
+
+  return window;
+}
@@ -68,8 +68,10 @@ typedef enum _windowtype {
   RIEMANN_WINDOW,
   BLACKMANHARRIS_WINDOW,
   NUTTALL_WINDOW,
+  KAISER_WINDOW,	// needs its shape, see makekaiser
 } Windowtype;
 
 extern REAL *makewindow(Windowtype type, int size, REAL *window);
+extern REAL *makekaiser(int size, REAL beta, REAL *window);
 
 #endif